@@ -69,14 +69,14 @@ void BatchTrafficManager::_RetireFlit( Flit *f, int dest )
   TrafficManager::_RetireFlit(f, dest);
 }
 
-int BatchTrafficManager::_IssuePacket( int source, int cl )
+int BatchTrafficManager::_IssuePacket( int source, int cl, int time )
 {
   int result = 0;
   if(_use_read_write[cl]) { //read write packets
     //check queue for waiting replies.
     //check to make sure it is on time yet
     if(!_repliesPending[source].empty()) {
-      if(_repliesPending[source].front()->time <= _time) {
+      if(_repliesPending[source].front()->time <= time) {
 	result = -1;
       }
     } else {
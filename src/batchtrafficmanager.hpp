@@ -53,7 +53,7 @@ protected:
 
   virtual void _RetireFlit( Flit *f, int dest );
 
-  virtual int _IssuePacket( int source, int cl );
+  virtual int _IssuePacket( int source, int cl, int time );
   virtual void _ClearStats( );
   virtual bool _SingleSim( );
 
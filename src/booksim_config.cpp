@@ -54,6 +54,17 @@ BookSimConfig::BookSimConfig( )
   _int_map["c"] = 1; //concentration
   AddStrField( "routing_function", "none" );
 
+  // storage of channel delay lines: "object" or "flat"
+  AddStrField( "channel_backend", "object" );
+
+  // router regions simulated, with their terminals, on threads of their
+  // own (0: sequential)
+  _int_map["parallel_regions"] = 0;
+
+  // random numbers drawn by the routers and terminals come from a stream
+  // per router and node (implied by parallel_regions)
+  _int_map["random_streams"] = 0;
+
   //simulator tries to correclty adjust latency for node/router placement 
   _int_map["use_noc_latency"] = 1;
 
@@ -68,6 +79,9 @@ BookSimConfig::BookSimConfig( )
   _int_map["link_failures"] = 0; //legacy
   _int_map["fail_seed"]     = 0; //legacy
   AddStrField( "fail_seed", "" ); // workaround to allow special "time" value
+  // links failed and restored during the simulation, as a list of
+  // {cycle,router,output port,1 to fail or 0 to restore}
+  AddStrField( "link_fault_schedule", "" );
 
   //==== Single-node options ===============================
 
@@ -225,6 +239,9 @@ BookSimConfig::BookSimConfig( )
   // types:
   //   latency    - average + latency distribution for a particular injection rate
   //   throughput - sustained throughput for a particular injection rate
+  //   batch      - fixed number of packets per node in each batch
+  //   trace      - replay of a binary packet trace (see packet_trace.hpp)
+  //   collective - closed-loop collective operations (see collectivetrafficmanager.hpp)
 
   AddStrField( "sim_type", "latency" );
 
@@ -236,7 +253,8 @@ BookSimConfig::BookSimConfig( )
   // whether or not to measure statistics for a given traffic class
   _int_map["measure_stats"] = 1;
   AddStrField("measure_stats", ""); // workaround to allow for vector specification
-  //whether to enable per pair statistics, caution N^2 memory usage
+  //whether to enable per pair statistics: 0 = off, 1 = dense storage 
+  //(caution N^2 memory usage), 2 = sparse storage for communicating pairs only
   _int_map["pair_stats"] = 0;
 
   // if avg. latency exceeds the threshold, assume unstable
@@ -255,6 +273,29 @@ BookSimConfig::BookSimConfig( )
   _float_map["acc_stopping_thres"] = 0.05;
   AddStrField("acc_stopping_thres", ""); // workaround to allow for vector specification
 
+  // stopping rule for the measurement phase:
+  //   change - relative change between successive sample periods (see above)
+  //   ci     - batch means confidence interval over sample periods
+  AddStrField("stopping_rule", "change");
+  _float_map["ci_precision"] = 0.01; // relative half-width of the confidence interval
+  _float_map["ci_confidence"] = 0.95; // confidence level
+  _int_map["ci_min_batches"] = 5; // minimum number of sample periods before stopping (>= 4)
+
+  // warm-up rule:
+  //   change - warmup_periods sample periods, or if 0, relative change 
+  //            between successive sample periods (see above)
+  //   mser   - MSER-5 truncation over mean latencies of mser_window cycles
+  AddStrField("warmup_rule", "change");
+  _int_map["mser_window"] = 50;
+  _int_map["mser_min_batches"] = 5; // minimum number of 5-window batches (>= 5)
+
+  // abort latency simulations once, over the last saturation_periods sample 
+  // periods, the in-flight flit count grew by more than this fraction of the 
+  // flits accepted, or the source queue lag grew by more than this fraction 
+  // of the elapsed cycles; negative values disable the check
+  _float_map["saturation_thres"] = -1.0;
+  _int_map["saturation_periods"] = 2;
+
   _int_map["sim_count"]     = 1;   // number of simulations to perform
 
 
@@ -276,6 +317,16 @@ BookSimConfig::BookSimConfig( )
 
   _int_map["viewer_trace"] = 0;
 
+  _int_map["profile"] = 0;
+
+  AddStrField("event_trace", "");
+  _int_map["event_trace_start"] = 0;
+  _int_map["event_trace_end"] = -1;
+
+  AddStrField("util_sample_out", "");
+  _int_map["util_sample_period"] = 1000;
+  AddStrField("util_sample_format", "csv");
+
   AddStrField("watch_file", "");
   
   AddStrField("watch_flits", "");
@@ -286,7 +337,12 @@ BookSimConfig::BookSimConfig( )
 
   AddStrField("stats_out", "");
 
-#ifdef TRACK_FLOWS
+  // optional instrumentation
+  _int_map["track_flows"] = 0;
+  _int_map["track_stalls"] = 0;
+  _int_map["track_buffers"] = 0;
+  _int_map["track_credits"] = 0;
+
   AddStrField("injected_flits_out", "");
   AddStrField("received_flits_out", "");
   AddStrField("stored_flits_out", "");
@@ -294,16 +350,27 @@ BookSimConfig::BookSimConfig( )
   AddStrField("outstanding_credits_out", "");
   AddStrField("ejected_flits_out", "");
   AddStrField("active_packets_out", "");
-#endif
 
-#ifdef TRACK_CREDITS
   AddStrField("used_credits_out", "");
   AddStrField("free_credits_out", "");
   AddStrField("max_credits_out", "");
-#endif
 
   // batch only -- packet sequence numbers
   AddStrField("sent_packets_out", "");
+
+  // trace only -- binary packet trace to replay
+  AddStrField("trace_file", "");
+  _float_map["trace_time_scale"] = 1.0; // multiplier applied to trace timestamps
+  _int_map["trace_loop"] = 1; // number of passes through the trace, 0 = loop until max_samples sample periods
+
+  // collective only -- collective operation, vector size in packets and 
+  // number of iterations
+  AddStrField("collective", "ring_allreduce"); // ring_allreduce, rd_allreduce, alltoall, broadcast
+  _int_map["collective_size"] = 64;
+  _int_map["collective_iterations"] = 10;
+
+  // capture all generated packets to a binary trace for later replay
+  AddStrField("trace_out", "");
   
   //==================Power model params=====================
   _int_map["sim_power"] = 0;
@@ -311,9 +378,20 @@ BookSimConfig::BookSimConfig( )
   AddStrField("tech_file", "");
   _int_map["channel_width"] = 128;
   _int_map["channel_sweep"] = 0;
+  // energy time series, accounted every power_epoch_period cycles
+  AddStrField("power_epoch_out", "");
+  _int_map["power_epoch_period"] = 1000;
 
   //==================Network file===========================
   AddStrField("network_file","");
+  // threads used to build routing tables, 0 for one per processor
+  _int_map["route_threads"] = 0;
+  // extra cycles over the shortest path allowed for ecmp_* anynet routing
+  _int_map["multipath_slack"] = 0;
+  // binary cache of the parsed network file and its routing table, stored
+  // next to the file unless a directory is given
+  _int_map["network_cache"] = 0;
+  AddStrField("network_cache_dir", "");
 }
 
 
@@ -50,10 +50,8 @@ Module( parent, name ), _occupancy(0)
     _vc[i] = new VC(config, outputs, this, vc_name.str( ) );
   }
 
-#ifdef TRACK_BUFFERS
-  int classes = config.GetInt("classes");
-  _class_occupancy.resize(classes, 0);
-#endif
+  _class_occupancy.Init(config.GetInt("track_buffers") > 0, 
+			config.GetInt("classes"));
 }
 
 Buffer::~Buffer()
@@ -70,9 +68,7 @@ void Buffer::AddFlit( int vc, Flit *f )
   }
   ++_occupancy;
   _vc[vc]->AddFlit(f);
-#ifdef TRACK_BUFFERS
-  ++_class_occupancy[f->cl];
-#endif
+  ++_class_occupancy(f->cl);
 }
 
 void Buffer::Display( ostream & os ) const
@@ -35,6 +35,7 @@
 #include "outputset.hpp"
 #include "routefunc.hpp"
 #include "config_utils.hpp"
+#include "class_counters.hpp"
 
 class Buffer : public Module {
   
@@ -43,9 +44,8 @@ class Buffer : public Module {
 
   vector<VC*> _vc;
 
-#ifdef TRACK_BUFFERS
-  vector<int> _class_occupancy;
-#endif
+  // flits per class (track_buffers)
+  ClassCounters _class_occupancy;
 
 public:
   
@@ -58,11 +58,9 @@ public:
   inline Flit *RemoveFlit( int vc )
   {
     --_occupancy;
-#ifdef TRACK_BUFFERS
     int cl = _vc[vc]->FrontFlit()->cl;
-    assert(_class_occupancy[cl] > 0);
-    --_class_occupancy[cl];
-#endif
+    assert(!_class_occupancy.Enabled() || (_class_occupancy.Get(cl) > 0));
+    --_class_occupancy(cl);
     return _vc[vc]->RemoveFlit( );
   }
   
@@ -148,12 +146,10 @@ public:
     return _vc[vc]->GetOccupancy( );
   }
 
-#ifdef TRACK_BUFFERS
   inline int GetOccupancyForClass(int c) const
   {
-    return _class_occupancy[c];
+    return _class_occupancy.Get(c);
   }
-#endif
 
   void Display( ostream & os = cout ) const;
 };
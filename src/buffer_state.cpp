@@ -557,11 +557,11 @@ BufferState::BufferState( const Configuration& config, Module *parent, const str
   _last_id.resize(_vcs, -1);
   _last_pid.resize(_vcs, -1);
 
-#ifdef TRACK_BUFFERS
-  _classes = config.GetInt("classes");
-  _outstanding_classes.resize(_vcs);
-  _class_occupancy.resize(_classes, 0);
-#endif
+  _track_buffers = (config.GetInt("track_buffers") > 0);
+  if(_track_buffers) {
+    _outstanding_classes.resize(_vcs);
+  }
+  _class_occupancy.Init(_track_buffers, config.GetInt("classes"));
 }
 
 BufferState::~BufferState()
@@ -601,14 +601,13 @@ void BufferState::ProcessCredit( Credit const * const c )
       _in_use_by[vc] = -1;
     }
 
-#ifdef TRACK_BUFFERS
-    assert(!_outstanding_classes[vc].empty());
-    int cl = _outstanding_classes[vc].front();
-    _outstanding_classes[vc].pop();
-    assert((cl >= 0) && (cl < _classes));
-    assert(_class_occupancy[cl] > 0);
-    --_class_occupancy[cl];
-#endif
+    if(_track_buffers) {
+      assert(!_outstanding_classes[vc].empty());
+      int cl = _outstanding_classes[vc].front();
+      _outstanding_classes[vc].pop();
+      assert(_class_occupancy.Get(cl) > 0);
+      --_class_occupancy(cl);
+    }
 
     _buffer_policy->FreeSlotFor(vc);
 
@@ -632,10 +631,10 @@ void BufferState::SendingFlit( Flit const * const f )
   
   _buffer_policy->SendingFlit(f);
   
-#ifdef TRACK_BUFFERS
-  _outstanding_classes[vc].push(f->cl);
-  ++_class_occupancy[f->cl];
-#endif
+  if(_track_buffers) {
+    _outstanding_classes[vc].push(f->cl);
+    ++_class_occupancy(f->cl);
+  }
 
   if ( f->tail ) {
     _tail_sent[vc] = true;
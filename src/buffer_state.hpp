@@ -35,6 +35,7 @@
 #include "flit.hpp"
 #include "credit.hpp"
 #include "config_utils.hpp"
+#include "class_counters.hpp"
 
 class BufferState : public Module {
   
@@ -169,11 +170,11 @@ class BufferState : public Module {
   vector<int> _last_id;
   vector<int> _last_pid;
 
-#ifdef TRACK_BUFFERS
-  int _classes;
+  // credits in use per class (track_buffers); the class of each 
+  // outstanding credit is queued so returned credits can be attributed
+  bool _track_buffers;
   vector<queue<int> > _outstanding_classes;
-  vector<int> _class_occupancy;
-#endif
+  ClassCounters _class_occupancy;
 
 public:
 
@@ -226,12 +227,9 @@ public:
     return _vc_occupancy[vc];
   }
   
-#ifdef TRACK_BUFFERS
   inline int OccupancyForClass(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _class_occupancy[c];
+    return _class_occupancy.Get(c);
   }
-#endif
 
   void Display( ostream & os = cout ) const;
 };
@@ -37,12 +37,13 @@
 #ifndef _CHANNEL_HPP
 #define _CHANNEL_HPP
 
-#include <queue>
+#include <vector>
 #include <cassert>
 
 #include "globals.hpp"
 #include "module.hpp"
 #include "timed_module.hpp"
+#include "channel_array.hpp"
 
 using namespace std;
 
@@ -66,17 +67,34 @@ public:
   virtual void Evaluate() {}
   virtual void WriteOutputs();
 
+  friend class ChannelArray<T>;
+
 protected:
   int _delay;
   T * _input;
   T * _output;
-  queue<pair<int, T *> > _wait_queue;
+
+  // delay line; _next is the slot delivered by the next WriteOutputs, and
+  // data read in the same cycle goes into the slot before it
+  vector<T *> _slots;
+  int _next;
+
+  // set once the delay line has moved into a network-wide ChannelArray
+  ChannelArray<T> * _array;
+  int _link;
+
+  void _Attach(ChannelArray<T> * array, int link);
+
+  // called when data enters and leaves the delay line
+  virtual void _Depart(T * data) {}
+  virtual void _Arrive(T * data) {}
 
 };
 
 template<typename T>
 Channel<T>::Channel(Module * parent, string const & name)
-  : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+  : TimedModule(parent, name), _delay(1), _input(0), _output(0), 
+    _slots(1, (T *)0), _next(0), _array(0), _link(-1) {
 }
 
 template<typename T>
@@ -84,42 +102,58 @@ void Channel<T>::SetLatency(int cycles) {
   if(cycles <= 0) {
     Error("Channel must have positive delay.");
   }
+  assert(!_array);
   _delay = cycles ;
+  _slots.assign(_delay, 0);
+  _next = 0;
+}
+
+template<typename T>
+void Channel<T>::_Attach(ChannelArray<T> * array, int link) {
+  assert(!_input && !_output);
+  _array = array;
+  _link = link;
+  vector<T *>().swap(_slots);
 }
 
 template<typename T>
 void Channel<T>::Send(T * data) {
-  _input = data;
+  if(_array) {
+    _array->Send(_link, data);
+  } else {
+    _input = data;
+  }
 }
 
 template<typename T>
 T * Channel<T>::Receive() {
-  return _output;
+  return _array ? _array->Receive(_link) : _output;
 }
 
 template<typename T>
 void Channel<T>::ReadInputs() {
+  assert(!_array);
   if(_input) {
-    _wait_queue.push(make_pair(GetSimTime() + _delay - 1, _input));
+    _Depart(_input);
+    T * & slot = _slots[(_next > 0) ? (_next - 1) : (_delay - 1)];
+    assert(!slot);
+    slot = _input;
     _input = 0;
   }
 }
 
 template<typename T>
 void Channel<T>::WriteOutputs() {
-  _output = 0;
-  if(_wait_queue.empty()) {
-    return;
+  assert(!_array);
+  T * & slot = _slots[_next];
+  if(++_next == _delay) {
+    _next = 0;
   }
-  pair<int, T *> const & item = _wait_queue.front();
-  int const & time = item.first;
-  if(GetSimTime() < time) {
-    return;
+  _output = slot;
+  if(_output) {
+    slot = 0;
+    _Arrive(_output);
   }
-  assert(GetSimTime() == time);
-  _output = item.second;
-  assert(_output);
-  _wait_queue.pop();
 }
 
 #endif
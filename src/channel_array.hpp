@@ -0,0 +1,195 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//////////////////////////////////////////////////////////////////////
+//
+//  File Name: channel_array.hpp
+//
+//  The ChannelArray holds the delay lines of all channels of one type
+//   in a network as flat arrays, one entry per link, so that the
+//   network can advance every link in a single pass instead of
+//   ticking each Channel object on its own. Channels attached to an
+//   array keep their Send/Receive interface but no longer store any
+//   flits or credits themselves.
+//
+//  For the parallel engine the delay lines can instead be indexed by
+//   cycle (SetRings); each end of a link is then advanced on its own,
+//   by the thread that owns the sending or the receiving router.
+//
+/////
+#ifndef _CHANNEL_ARRAY_HPP
+#define _CHANNEL_ARRAY_HPP
+
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+template<typename T> class Channel;
+
+template<typename T>
+class ChannelArray {
+public:
+  ChannelArray() {}
+
+  // Move the delay line of a channel into the array; the channel's
+  // latency must be final at this point.
+  int Attach(Channel<T> * channel);
+
+  inline int Size() const { return (int)_handles.size(); }
+
+  inline void Send(int link, T * data) { _input[link] = data; }
+  inline T * Receive(int link) const { return _output[link]; }
+
+  void ReadInputs();
+  void WriteOutputs();
+
+  // Switch to delay lines indexed by cycle, with ring[l] slots for link
+  // l; enough slots must be given for the sender to run ahead of the
+  // receiver by as many cycles as the parallel engine allows.
+  void SetRings(vector<int> const & ring);
+
+  // Receiving end: hand out what arrives in this cycle.
+  void Deliver(vector<int> const & links, int cycle);
+  // Sending end: put what was sent in this cycle on the line.
+  void Commit(vector<int> const & links, int cycle);
+
+private:
+  // per link
+  vector<Channel<T> *> _handles;
+  vector<int> _delay;
+  vector<int> _base;
+  vector<int> _next;
+  vector<T *> _input;
+  vector<T *> _output;
+
+  // delay line slots of all links; link l owns _delay[l] slots starting
+  // at _base[l], of which _next[l] is delivered by the next WriteOutputs
+  // and the one before it is filled by ReadInputs
+  vector<T *> _slots;
+
+  // with SetRings, link l owns _ring[l] slots instead, and data sent in
+  // cycle t waits in slot (t + _delay[l] + 1) % _ring[l]
+  vector<int> _ring;
+};
+
+template<typename T>
+int ChannelArray<T>::Attach(Channel<T> * channel) {
+  int const link = _handles.size();
+  int const delay = channel->GetLatency();
+  _handles.push_back(channel);
+  _delay.push_back(delay);
+  _base.push_back(_slots.size());
+  _next.push_back(0);
+  _input.push_back(0);
+  _output.push_back(0);
+  _slots.resize(_slots.size() + delay, 0);
+  channel->_Attach(this, link);
+  return link;
+}
+
+template<typename T>
+void ChannelArray<T>::ReadInputs() {
+  int const links = _handles.size();
+  for(int l = 0; l < links; ++l) {
+    T * const data = _input[l];
+    if(data) {
+      _handles[l]->_Depart(data);
+      int const next = _next[l];
+      T * & slot = _slots[_base[l] + ((next > 0) ? next : _delay[l]) - 1];
+      assert(!slot);
+      slot = data;
+      _input[l] = 0;
+    }
+  }
+}
+
+template<typename T>
+void ChannelArray<T>::WriteOutputs() {
+  int const links = _handles.size();
+  for(int l = 0; l < links; ++l) {
+    int & next = _next[l];
+    T * & slot = _slots[_base[l] + next];
+    if(++next == _delay[l]) {
+      next = 0;
+    }
+    T * const data = slot;
+    _output[l] = data;
+    if(data) {
+      slot = 0;
+      _handles[l]->_Arrive(data);
+    }
+  }
+}
+
+template<typename T>
+void ChannelArray<T>::SetRings(vector<int> const & ring) {
+  int const links = _handles.size();
+  assert((int)ring.size() == links);
+  _ring = ring;
+  int size = 0;
+  for(int l = 0; l < links; ++l) {
+    assert(!_input[l] && !_output[l]);
+    assert(_ring[l] > _delay[l] + 1);
+    _base[l] = size;
+    size += _ring[l];
+  }
+  _slots.assign(size, 0);
+}
+
+template<typename T>
+void ChannelArray<T>::Deliver(vector<int> const & links, int cycle) {
+  assert(!_ring.empty());
+  for(size_t i = 0; i < links.size(); ++i) {
+    int const l = links[i];
+    T * & slot = _slots[_base[l] + cycle % _ring[l]];
+    T * const data = slot;
+    _output[l] = data;
+    if(data) {
+      slot = 0;
+      _handles[l]->_Arrive(data);
+    }
+  }
+}
+
+template<typename T>
+void ChannelArray<T>::Commit(vector<int> const & links, int cycle) {
+  assert(!_ring.empty());
+  for(size_t i = 0; i < links.size(); ++i) {
+    int const l = links[i];
+    T * const data = _input[l];
+    if(data) {
+      _handles[l]->_Depart(data);
+      T * & slot = _slots[_base[l] + (cycle + _delay[l] + 1) % _ring[l]];
+      assert(!slot);
+      slot = data;
+      _input[l] = 0;
+    }
+  }
+}
+
+#endif
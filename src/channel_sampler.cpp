@@ -0,0 +1,251 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+#include "channel_sampler.hpp"
+
+char const ChannelSampler::MAGIC[8] = {'B', 'S', 'S', 'A', 'M', 'P', 'L', 0};
+
+ChannelSampler::ChannelSampler( string const & filename, 
+				vector<Network *> const & net, bool binary )
+  : _filename(filename), _file(NULL), _binary(binary), _net(net), 
+    _time_offset(0), _last_time(0), _stop(false)
+{
+  _last_flits.resize(_net.size());
+  for(size_t s = 0; s < _net.size(); ++s) {
+    vector<FlitChannel *> const & chan = _net[s]->GetChannels();
+    _last_flits[s].resize(chan.size(), 0);
+    for(size_t c = 0; c < chan.size(); ++c) {
+      ostringstream name;
+      name << "s" << s << ".";
+      Router const * const router = chan[c]->GetSource();
+      if(router) {
+	name << "r" << router->GetID() << ".o" << chan[c]->GetSourcePort();
+      } else {
+	name << "ch" << c;
+      }
+      name << ".flits";
+      _columns.push_back(name.str());
+    }
+    vector<Router *> const & routers = _net[s]->GetRouters();
+    for(size_t r = 0; r < routers.size(); ++r) {
+      for(int i = 0; i < routers[r]->NumInputs(); ++i) {
+	ostringstream name;
+	name << "s" << s << ".r" << r << ".i" << i << ".occupancy";
+	_columns.push_back(name.str());
+      }
+      for(int o = 0; o < routers[r]->NumOutputs(); ++o) {
+	ostringstream name;
+	name << "s" << s << ".r" << r << ".o" << o << ".credits";
+	_columns.push_back(name.str());
+      }
+    }
+  }
+
+  _file = fopen(filename.c_str(), _binary ? "wb" : "w");
+  if(!_file) {
+    cout << "Error: Unable to open sample file: " << filename << endl;
+    exit(-1);
+  }
+  if(_binary) {
+    uint32_t const version = VERSION;
+    uint32_t const columns = _columns.size();
+    fwrite(MAGIC, 1, sizeof(MAGIC), _file);
+    fwrite(&version, sizeof(version), 1, _file);
+    fwrite(&columns, sizeof(columns), 1, _file);
+    for(size_t c = 0; c < _columns.size(); ++c) {
+      fwrite(_columns[c].c_str(), 1, _columns[c].size() + 1, _file);
+    }
+  } else {
+    fputs("time", _file);
+    for(size_t c = 0; c < _columns.size(); ++c) {
+      fputc(',', _file);
+      fputs(_columns[c].c_str(), _file);
+    }
+    fputc('\n', _file);
+  }
+
+  _block.time.reserve(BLOCK_ROWS);
+  _block.values.reserve(BLOCK_ROWS * _columns.size());
+  pthread_mutex_init(&_lock, NULL);
+  pthread_cond_init(&_not_empty, NULL);
+  pthread_cond_init(&_not_full, NULL);
+  if(pthread_create(&_thread, NULL, &ChannelSampler::_WriteBehind, this)) {
+    cout << "Error: Unable to start sample writer thread." << endl;
+    exit(-1);
+  }
+}
+
+ChannelSampler::~ChannelSampler( )
+{
+  pthread_mutex_lock(&_lock);
+  if(!_block.time.empty()) {
+    _pending.push_back(Block());
+    _pending.back().time.swap(_block.time);
+    _pending.back().values.swap(_block.values);
+  }
+  _stop = true;
+  pthread_cond_signal(&_not_empty);
+  pthread_mutex_unlock(&_lock);
+  pthread_join(_thread, NULL);
+  pthread_cond_destroy(&_not_full);
+  pthread_cond_destroy(&_not_empty);
+  pthread_mutex_destroy(&_lock);
+  if(fclose(_file)) {
+    cout << "Error: Unable to write sample file: " << _filename << endl;
+    exit(-1);
+  }
+}
+
+void ChannelSampler::Sample( int time )
+{
+  // time restarts from zero between simulations
+  long long t = _time_offset + time;
+  if(t < _last_time) {
+    _time_offset = _last_time - time;
+    t = _last_time;
+  }
+  _last_time = t;
+
+  _block.time.push_back(t);
+  for(size_t s = 0; s < _net.size(); ++s) {
+    vector<FlitChannel *> const & chan = _net[s]->GetChannels();
+    for(size_t c = 0; c < chan.size(); ++c) {
+      int const * const activity = chan[c]->GetActivity();
+      long long flits = 0;
+      for(int cl = 0; cl < chan[c]->NumClasses(); ++cl) {
+	flits += activity[cl];
+      }
+      // activity counters are not reset between simulations
+      long long const delta = flits - _last_flits[s][c];
+      _block.values.push_back((delta > 0) ? (uint32_t)delta : 0);
+      _last_flits[s][c] = flits;
+    }
+    vector<Router *> const & routers = _net[s]->GetRouters();
+    for(size_t r = 0; r < routers.size(); ++r) {
+      Router const * const router = routers[r];
+      for(int i = 0; i < router->NumInputs(); ++i) {
+	_block.values.push_back(router->GetBufferOccupancy(i));
+      }
+      for(int o = 0; o < router->NumOutputs(); ++o) {
+	_block.values.push_back(router->GetUsedCredit(o));
+      }
+    }
+  }
+  if(_block.time.size() >= BLOCK_ROWS) {
+    _Push();
+  }
+}
+
+void ChannelSampler::_Push( )
+{
+  pthread_mutex_lock(&_lock);
+  while(_pending.size() >= MAX_BLOCKS) {
+    pthread_cond_wait(&_not_full, &_lock);
+  }
+  _pending.push_back(Block());
+  _pending.back().time.swap(_block.time);
+  _pending.back().values.swap(_block.values);
+  pthread_cond_signal(&_not_empty);
+  pthread_mutex_unlock(&_lock);
+  _block.time.reserve(BLOCK_ROWS);
+  _block.values.reserve(BLOCK_ROWS * _columns.size());
+}
+
+void * ChannelSampler::_WriteBehind( void * sampler )
+{
+  ((ChannelSampler *)sampler)->_Consume();
+  return NULL;
+}
+
+void ChannelSampler::_Consume( )
+{
+  Block b;
+  while(true) {
+    pthread_mutex_lock(&_lock);
+    while(!_stop && _pending.empty()) {
+      pthread_cond_wait(&_not_empty, &_lock);
+    }
+    bool const done = _pending.empty();
+    if(!done) {
+      b.time.swap(_pending.front().time);
+      b.values.swap(_pending.front().values);
+      _pending.pop_front();
+      pthread_cond_signal(&_not_full);
+    }
+    pthread_mutex_unlock(&_lock);
+    if(done) {
+      break;
+    }
+    _WriteBlock(b);
+    b.time.clear();
+    b.values.clear();
+  }
+}
+
+void ChannelSampler::_WriteBlock( Block const & b )
+{
+  size_t const rows = b.time.size();
+  size_t const columns = _columns.size();
+  assert(b.values.size() == rows * columns);
+  bool ok = true;
+  if(_binary) {
+    uint32_t const n = rows;
+    ok = ok && (fwrite(&n, sizeof(n), 1, _file) == 1);
+    ok = ok && (fwrite(&b.time[0], sizeof(int64_t), rows, _file) == rows);
+    _column_buffer.resize(rows);
+    for(size_t c = 0; c < columns; ++c) {
+      for(size_t r = 0; r < rows; ++r) {
+	_column_buffer[r] = b.values[r * columns + c];
+      }
+      ok = ok && 
+	(fwrite(&_column_buffer[0], sizeof(uint32_t), rows, _file) == rows);
+    }
+  } else {
+    char field[32];
+    for(size_t r = 0; r < rows; ++r) {
+      _text.clear();
+      sprintf(field, "%lld", (long long)b.time[r]);
+      _text += field;
+      for(size_t c = 0; c < columns; ++c) {
+	sprintf(field, ",%u", b.values[r * columns + c]);
+	_text += field;
+      }
+      _text += '\n';
+      ok = ok && (fwrite(_text.data(), 1, _text.size(), _file) == _text.size());
+    }
+  }
+  if(!ok) {
+    cout << "Error: Unable to write sample file: " << _filename << endl;
+    exit(-1);
+  }
+}
@@ -0,0 +1,115 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*channel_sampler.hpp
+ *
+ *Periodic snapshots of network utilization: flits sent on every channel
+ *since the previous sample, buffer occupancy at every router input, and
+ *credits in use at every router output.  Each sample is one row of a
+ *fixed set of columns.  Rows are formatted and written by a background
+ *thread, either as CSV or as a binary file of column-major blocks.
+ *
+ *Binary layout: magic, version, column count, NUL-terminated column 
+ *names; then blocks of (uint32 rows, int64 time[rows], and for each 
+ *column uint32 value[rows]), all in host byte order.
+ */
+
+#ifndef _CHANNEL_SAMPLER_HPP_
+#define _CHANNEL_SAMPLER_HPP_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "network.hpp"
+
+using namespace std;
+
+class ChannelSampler {
+
+public:
+
+  static char const MAGIC[8];
+  static uint32_t const VERSION = 1;
+
+private:
+
+  static size_t const BLOCK_ROWS = 64;
+  static size_t const MAX_BLOCKS = 16;
+
+  struct Block {
+    vector<int64_t> time;
+    // row-major, converted to columns by the writer
+    vector<uint32_t> values;
+  };
+
+  string _filename;
+  FILE * _file;
+  bool _binary;
+
+  vector<Network *> _net;
+  vector<string> _columns;
+  // cumulative per-channel flit counts at the previous sample
+  vector<vector<long long> > _last_flits;
+
+  long long _time_offset;
+  long long _last_time;
+
+  Block _block;
+
+  pthread_t _thread;
+  pthread_mutex_t _lock;
+  pthread_cond_t _not_empty;
+  pthread_cond_t _not_full;
+  deque<Block> _pending;
+  bool _stop;
+
+  // writer state
+  vector<uint32_t> _column_buffer;
+  string _text;
+
+  static void * _WriteBehind( void * sampler );
+  void _Consume( );
+  void _WriteBlock( Block const & b );
+  void _Push( );
+
+public:
+
+  ChannelSampler( string const & filename, vector<Network *> const & net, 
+		  bool binary = false );
+  ~ChannelSampler( );
+
+  void Sample( int time );
+
+  inline int NumColumns( ) const { return _columns.size(); }
+
+};
+
+#endif
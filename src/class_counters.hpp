@@ -0,0 +1,112 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*class_counters.hpp
+ *
+ *Per-class counter arrays for the optional flow, stall and buffer
+ *instrumentation (track_flows, track_stalls, track_buffers).  Whether a
+ *block counts is decided once, when it is sized: a disabled block maps
+ *every (class, index) to a single scratch slot, so the update sites need
+ *no check and the owning classes keep the same layout either way.  Only
+ *the readers look at whether the block is enabled.
+ */
+
+#ifndef _CLASS_COUNTERS_HPP_
+#define _CLASS_COUNTERS_HPP_
+
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+class ClassCounters {
+
+  bool _enabled;
+  int _classes;
+  int _size;
+  int _class_stride;
+  int _index_stride;
+  vector<int> _counts;
+
+public:
+
+  ClassCounters( ) 
+    : _enabled(false), _classes(0), _size(0), _class_stride(0), 
+      _index_stride(0), _counts(1, 0) { }
+
+  void Init( bool enabled, int classes, int size = 1 ) {
+    _enabled = enabled;
+    _classes = classes;
+    _size = size;
+    if(enabled) {
+      _class_stride = size;
+      _index_stride = 1;
+      _counts.assign(classes * size, 0);
+    } else {
+      _class_stride = 0;
+      _index_stride = 0;
+      _counts.assign(1, 0);
+    }
+  }
+
+  inline bool Enabled( ) const { return _enabled; }
+
+  inline int & operator()( int cl, int index = 0 ) {
+    return _counts[cl * _class_stride + index * _index_stride];
+  }
+
+  inline int Get( int cl, int index = 0 ) const {
+    assert((cl >= 0) && (cl < _classes) && (index >= 0) && (index < _size));
+    return _enabled ? _counts[cl * _class_stride + index] : 0;
+  }
+
+  // all counters of one class
+  vector<int> Row( int cl ) const {
+    assert((cl >= 0) && (cl < _classes));
+    if(!_enabled) {
+      return vector<int>(_size, 0);
+    }
+    return vector<int>(_counts.begin() + cl * _class_stride, 
+		       _counts.begin() + (cl + 1) * _class_stride);
+  }
+
+  void Reset( int cl ) {
+    assert((cl >= 0) && (cl < _classes));
+    if(_enabled) {
+      for(int i = 0; i < _size; ++i) {
+	_counts[cl * _class_stride + i] = 0;
+      }
+    }
+  }
+
+  void Reset( ) {
+    _counts.assign(_counts.size(), 0);
+  }
+
+};
+
+#endif
@@ -0,0 +1,287 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sstream>
+#include <algorithm>
+
+#include "collectivetrafficmanager.hpp"
+
+CollectiveTrafficManager::CollectiveTrafficManager( const Configuration &config, 
+						    const vector<Network *> & net )
+  : TrafficManager(config, net), _messages_left(0), 
+    _overall_min_collective_time(0), _overall_avg_collective_time(0), 
+    _overall_max_collective_time(0)
+{
+  if(_use_read_write[0]) {
+    Error( "Collective simulations do not support use_read_write." );
+  }
+  if(_nodes < 2) {
+    Error( "Collective simulations require at least two nodes." );
+  }
+
+  _collective = config.GetStr( "collective" );
+  _collective_size = config.GetInt( "collective_size" );
+  if(_collective_size <= 0) {
+    Error( "collective_size must be positive." );
+  }
+  _iterations = config.GetInt( "collective_iterations" );
+  if(_iterations <= 0) {
+    Error( "collective_iterations must be positive." );
+  }
+
+  if(_collective == "ring_allreduce") {
+    _BuildRingAllReduce();
+  } else if(_collective == "rd_allreduce") {
+    _BuildRecursiveDoublingAllReduce();
+  } else if(_collective == "alltoall") {
+    _BuildAllToAll();
+  } else if(_collective == "broadcast") {
+    _BuildBroadcast();
+  } else {
+    Error( "Unknown collective: " + _collective );
+  }
+
+  _deps_left.resize(_messages.size());
+  _packets_left.resize(_messages.size());
+
+  _collective_time = new Stats( this, "collective_time", 1.0, 1000 );
+  _stats["collective_time"] = _collective_time;
+}
+
+CollectiveTrafficManager::~CollectiveTrafficManager( )
+{
+  delete _collective_time;
+}
+
+int CollectiveTrafficManager::_AddMessage( int src, int dest, int packets )
+{
+  Message m;
+  m.src = src;
+  m.dest = dest;
+  m.packets = packets;
+  m.deps = 0;
+  _messages.push_back(m);
+  return _messages.size() - 1;
+}
+
+void CollectiveTrafficManager::_AddDependency( int before, int after )
+{
+  _messages[before].successors.push_back(after);
+  ++_messages[after].deps;
+}
+
+// Reduce-scatter followed by all-gather around a ring of all nodes; in 
+// each of the 2(N-1) steps every node forwards one 1/N chunk of the vector 
+// to its successor once it has received the previous step's chunk.
+void CollectiveTrafficManager::_BuildRingAllReduce( )
+{
+  int const chunk = max(1, (_collective_size + _nodes - 1) / _nodes);
+  int const steps = 2 * (_nodes - 1);
+  for(int s = 0; s < steps; ++s) {
+    for(int i = 0; i < _nodes; ++i) {
+      _AddMessage(i, (i + 1) % _nodes, chunk);
+      if(s > 0) {
+	_AddDependency((s - 1) * _nodes + (i + _nodes - 1) % _nodes, 
+		       s * _nodes + i);
+      }
+    }
+  }
+}
+
+// In step s every node exchanges the full vector with the node whose 
+// index differs in bit s, after receiving its partner's data from step s-1.
+void CollectiveTrafficManager::_BuildRecursiveDoublingAllReduce( )
+{
+  if(_nodes & (_nodes - 1)) {
+    Error( "rd_allreduce requires a power-of-two number of nodes." );
+  }
+  int s = 0;
+  for(int d = 1; d < _nodes; d <<= 1, ++s) {
+    for(int i = 0; i < _nodes; ++i) {
+      _AddMessage(i, i ^ d, _collective_size);
+      if(s > 0) {
+	_AddDependency((s - 1) * _nodes + (i ^ (d >> 1)), s * _nodes + i);
+      }
+    }
+  }
+}
+
+// Every node sends a 1/N chunk to every other node; sends are posted at 
+// once and ordered by increasing destination offset to spread the load.
+void CollectiveTrafficManager::_BuildAllToAll( )
+{
+  int const chunk = max(1, (_collective_size + _nodes - 1) / _nodes);
+  for(int s = 1; s < _nodes; ++s) {
+    for(int i = 0; i < _nodes; ++i) {
+      _AddMessage(i, (i + s) % _nodes, chunk);
+    }
+  }
+}
+
+// Binomial tree broadcast of the full vector from node 0; a node forwards 
+// the vector only after it has received it.
+void CollectiveTrafficManager::_BuildBroadcast( )
+{
+  vector<int> received(_nodes, -1);
+  for(int d = 1; d < _nodes; d <<= 1) {
+    for(int i = 0; (i < d) && (i + d < _nodes); ++i) {
+      int const m = _AddMessage(i, i + d, _collective_size);
+      if(received[i] >= 0) {
+	_AddDependency(received[i], m);
+      }
+      received[i + d] = m;
+    }
+  }
+}
+
+void CollectiveTrafficManager::_RetireFlit( Flit *f, int dest )
+{
+  if(f->tail) {
+    map<int, int>::iterator iter = _packet_message.find(f->pid);
+    if(iter != _packet_message.end()) {
+      int const m = iter->second;
+      _packet_message.erase(iter);
+      if(--_packets_left[m] == 0) {
+	--_messages_left;
+	vector<int> const & successors = _messages[m].successors;
+	for(size_t i = 0; i < successors.size(); ++i) {
+	  if(--_deps_left[successors[i]] == 0) {
+	    _ready.push_back(successors[i]);
+	  }
+	}
+      }
+    }
+  }
+  TrafficManager::_RetireFlit(f, dest);
+}
+
+void CollectiveTrafficManager::_Inject( )
+{
+  // all packets of a message are queued at its source as soon as the 
+  // message becomes ready
+  while(!_ready.empty()) {
+    int const m = _ready.front();
+    _ready.pop_front();
+    Message const & msg = _messages[m];
+    for(int p = 0; p < msg.packets; ++p) {
+      int const pid = _EnqueuePacket(msg.src, msg.dest, _GetNextPacketSize(0), 
+				     0, _time, Flit::ANY_TYPE, false);
+      _packet_message.insert(make_pair(pid, m));
+    }
+  }
+}
+
+void CollectiveTrafficManager::_ClearStats( )
+{
+  TrafficManager::_ClearStats();
+  _collective_time->Clear( );
+}
+
+bool CollectiveTrafficManager::_SingleSim( )
+{
+  cout << "Running " << _iterations << " iterations of " << _collective 
+       << " (" << _messages.size() << " messages per iteration)..." << endl;
+
+  for(int iter = 0; iter < _iterations; ++iter) {
+    _sim_state = running;
+    int const start_time = _time;
+
+    _messages_left = _messages.size();
+    for(size_t m = 0; m < _messages.size(); ++m) {
+      _deps_left[m] = _messages[m].deps;
+      _packets_left[m] = _messages[m].packets;
+      if(_deps_left[m] == 0) {
+	_ready.push_back(m);
+      }
+    }
+
+    int steps = 0;
+    while(_messages_left > 0) {
+      _Step();
+      ++steps;
+      if(steps % 1000 == 0) {
+	_DisplayRemaining();
+      }
+    }
+
+    cout << "Iteration " << iter + 1 << " completed in " 
+	 << _time - start_time << " cycles." << endl;
+    _collective_time->AddSample(_time - start_time);
+
+    UpdateStats();
+    DisplayStats();
+  }
+  _sim_state = draining;
+  _drain_time = _time;
+  return true;
+}
+
+void CollectiveTrafficManager::_UpdateOverallStats( )
+{
+  TrafficManager::_UpdateOverallStats();
+  _overall_min_collective_time += _collective_time->Min();
+  _overall_avg_collective_time += _collective_time->Average();
+  _overall_max_collective_time += _collective_time->Max();
+}
+
+string CollectiveTrafficManager::_OverallStatsCSV(int c) const
+{
+  ostringstream os;
+  os << TrafficManager::_OverallStatsCSV(c) << ','
+     << _overall_min_collective_time / (double)_total_sims << ','
+     << _overall_avg_collective_time / (double)_total_sims << ','
+     << _overall_max_collective_time / (double)_total_sims;
+  return os.str();
+}
+
+void CollectiveTrafficManager::WriteStats( ostream & os ) const
+{
+  TrafficManager::WriteStats(os);
+  os << "collective_time = " << _collective_time->Average() << ";" << endl;
+}
+
+void CollectiveTrafficManager::DisplayStats( ostream & os ) const
+{
+  TrafficManager::DisplayStats(os);
+  os << "Minimum collective completion time = " << _collective_time->Min() << endl
+     << "Average collective completion time = " << _collective_time->Average() << endl
+     << "Maximum collective completion time = " << _collective_time->Max() << endl;
+}
+
+void CollectiveTrafficManager::DisplayOverallStats( ostream & os ) const
+{
+  TrafficManager::DisplayOverallStats(os);
+  os << "Overall min collective completion time = " 
+     << _overall_min_collective_time / (double)_total_sims
+     << " (" << _total_sims << " samples)" << endl
+     << "Overall average collective completion time = " 
+     << _overall_avg_collective_time / (double)_total_sims
+     << " (" << _total_sims << " samples)" << endl
+     << "Overall max collective completion time = " 
+     << _overall_max_collective_time / (double)_total_sims
+     << " (" << _total_sims << " samples)" << endl;
+}
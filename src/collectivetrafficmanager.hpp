@@ -0,0 +1,105 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*collectivetrafficmanager.hpp
+ *
+ *Closed-loop workload made up of collective operations.  Each collective
+ *is expanded into a DAG of messages; a message is injected only once all
+ *messages it depends on have been received, and the time until the last
+ *message of an iteration is received is reported as its completion time.
+ */
+
+#ifndef _COLLECTIVETRAFFICMANAGER_HPP_
+#define _COLLECTIVETRAFFICMANAGER_HPP_
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include "config_utils.hpp"
+#include "stats.hpp"
+#include "trafficmanager.hpp"
+
+class CollectiveTrafficManager : public TrafficManager {
+
+protected:
+
+  struct Message {
+    int src;
+    int dest;
+    int packets;
+    int deps;
+    vector<int> successors;
+  };
+
+  string _collective;
+  int _collective_size;
+  int _iterations;
+
+  // the message DAG of one iteration and its execution state
+  vector<Message> _messages;
+  vector<int> _deps_left;
+  vector<int> _packets_left;
+  int _messages_left;
+  deque<int> _ready;
+  map<int, int> _packet_message;
+
+  Stats * _collective_time;
+  double _overall_min_collective_time;
+  double _overall_avg_collective_time;
+  double _overall_max_collective_time;
+
+  int _AddMessage( int src, int dest, int packets );
+  void _AddDependency( int before, int after );
+  void _BuildRingAllReduce( );
+  void _BuildRecursiveDoublingAllReduce( );
+  void _BuildAllToAll( );
+  void _BuildBroadcast( );
+
+  virtual void _RetireFlit( Flit *f, int dest );
+
+  virtual void _Inject( );
+  virtual void _ClearStats( );
+  virtual bool _SingleSim( );
+
+  virtual void _UpdateOverallStats( );
+
+  virtual string _OverallStatsCSV(int c = 0) const;
+
+public:
+
+  CollectiveTrafficManager( const Configuration &config, const vector<Network *> & net );
+  virtual ~CollectiveTrafficManager( );
+
+  virtual void WriteStats( ostream & os = cout ) const;
+  virtual void DisplayStats( ostream & os = cout ) const;
+  virtual void DisplayOverallStats( ostream & os = cout ) const;
+
+};
+
+#endif
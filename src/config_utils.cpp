@@ -42,11 +42,109 @@
 Configuration *Configuration::theConfig = 0;
 
 Configuration::Configuration()
+  : _resolved_size(0)
 {
   theConfig = this;
   _config_file = 0;
 }
 
+Configuration::Configuration(Configuration const & other)
+  : _config_file(0), _resolved_size(0), _str_map(other._str_map), 
+    _int_map(other._int_map), _float_map(other._float_map)
+{
+}
+
+Configuration & Configuration::operator=(Configuration const & other)
+{
+  if(this != &other) {
+    _str_map = other._str_map;
+    _int_map = other._int_map;
+    _float_map = other._float_map;
+    // the resolved entries point into the old maps
+    _params.clear();
+    _lookup_cache.clear();
+    _resolved_size = 0;
+  }
+  return *this;
+}
+
+void Configuration::_Resolve( ) const
+{
+  _params.clear();
+  _lookup_cache.assign(LOOKUP_CACHE_SIZE, make_pair((char const *)NULL, -1));
+
+  // all three maps are sorted by name, so a merge yields a sorted table
+  map<string, string>::const_iterator s = _str_map.begin();
+  map<string, int>::const_iterator i = _int_map.begin();
+  map<string, double>::const_iterator f = _float_map.begin();
+  while((s != _str_map.end()) || (i != _int_map.end()) || (f != _float_map.end())) {
+    string const * name = NULL;
+    if(s != _str_map.end()) {
+      name = &s->first;
+    }
+    if((i != _int_map.end()) && (!name || (i->first < *name))) {
+      name = &i->first;
+    }
+    if((f != _float_map.end()) && (!name || (f->first < *name))) {
+      name = &f->first;
+    }
+    Param p;
+    p.name = name->c_str();
+    p.str = NULL;
+    p.i = NULL;
+    p.f = NULL;
+    p.str_array_valid = false;
+    p.int_array_valid = false;
+    p.float_array_valid = false;
+    if((s != _str_map.end()) && (s->first == *name)) {
+      p.str = const_cast<string *>(&s->second);
+      ++s;
+    }
+    if((i != _int_map.end()) && (i->first == *name)) {
+      p.i = const_cast<int *>(&i->second);
+      ++i;
+    }
+    if((f != _float_map.end()) && (f->first == *name)) {
+      p.f = const_cast<double *>(&f->second);
+      ++f;
+    }
+    _params.push_back(p);
+  }
+  _resolved_size = _str_map.size() + _int_map.size() + _float_map.size();
+}
+
+Configuration::Param const * Configuration::_Find( char const * field ) const
+{
+  if(_resolved_size != _str_map.size() + _int_map.size() + _float_map.size()) {
+    _Resolve();
+  }
+
+  pair<char const *, int> & cached = 
+    _lookup_cache[((size_t)field >> 2) & (LOOKUP_CACHE_SIZE - 1)];
+  // the name is compared even on a hit, as the same address may hold a 
+  // different (non-literal) name by now
+  if((cached.first == field) && !strcmp(_params[cached.second].name, field)) {
+    return &_params[cached.second];
+  }
+
+  int lo = 0;
+  int hi = (int)_params.size() - 1;
+  while(lo <= hi) {
+    int const mid = (lo + hi) / 2;
+    int const cmp = strcmp(_params[mid].name, field);
+    if(cmp == 0) {
+      cached.first = field;
+      cached.second = mid;
+      return &_params[mid];
+    } else if(cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return NULL;
+}
+
 void Configuration::AddStrField(string const & field, string const & value)
 {
   _str_map[field] = value;
@@ -54,11 +152,12 @@ void Configuration::AddStrField(string const & field, string const & value)
 
 void Configuration::Assign(string const & field, string const & value)
 {
-  map<string, string>::const_iterator match;
-  
-  match = _str_map.find(field);
-  if(match != _str_map.end()) {
-    _str_map[field] = value;
+  Param const * const p = _Find(field.c_str());
+  if(p && p->str) {
+    *p->str = value;
+    p->str_array_valid = false;
+    p->int_array_valid = false;
+    p->float_array_valid = false;
   } else {
     ParseError("Unknown string field: " + field);
   }
@@ -66,11 +165,12 @@ void Configuration::Assign(string const & field, string const & value)
 
 void Configuration::Assign(string const & field, int value)
 {
-  map<string, int>::const_iterator match;
-  
-  match = _int_map.find(field);
-  if(match != _int_map.end()) {
-    _int_map[field] = value;
+  Param const * const p = _Find(field.c_str());
+  if(p && p->i) {
+    *p->i = value;
+  } else if(p && p->f) {
+    // integer literals are accepted for floating-point parameters
+    *p->f = (double)value;
   } else {
     ParseError("Unknown integer field: " + field);
   }
@@ -78,71 +178,84 @@ void Configuration::Assign(string const & field, int value)
 
 void Configuration::Assign(string const & field, double value)
 {
-  map<string, double>::const_iterator match;
-  
-  match = _float_map.find(field);
-  if(match != _float_map.end()) {
-    _float_map[field] = value;
+  Param const * const p = _Find(field.c_str());
+  if(p && p->f) {
+    *p->f = value;
   } else {
     ParseError("Unknown double field: " + field);
   }
 }
 
-string Configuration::GetStr(string const & field) const
+string const & Configuration::GetStr(char const * field) const
 {
-  map<string, string>::const_iterator match;
-
-  match = _str_map.find(field);
-  if(match != _str_map.end()) {
-    return match->second;
-  } else {
-    ParseError("Unknown string field: " + field);
+  Param const * const p = _Find(field);
+  if(!p || !p->str) {
+    ParseError("Unknown string field: " + string(field));
     exit(-1);
   }
+  return *p->str;
 }
 
-int Configuration::GetInt(string const & field) const
+int Configuration::GetInt(char const * field) const
 {
-  map<string, int>::const_iterator match;
-
-  match = _int_map.find(field);
-  if(match != _int_map.end()) {
-    return match->second;
-  } else {
-    ParseError("Unknown integer field: " + field);
+  Param const * const p = _Find(field);
+  if(!p || !p->i) {
+    ParseError("Unknown integer field: " + string(field));
     exit(-1);
   }
+  return *p->i;
 }
 
-double Configuration::GetFloat(string const & field) const
+double Configuration::GetFloat(char const * field) const
 {  
-  map<string,double>::const_iterator match;
-
-  match = _float_map.find(field);
-  if(match != _float_map.end()) {
-    return match->second;
-  } else {
-    ParseError("Unknown double field: " + field);
+  Param const * const p = _Find(field);
+  if(!p || !p->f) {
+    ParseError("Unknown double field: " + string(field));
     exit(-1);
   }
+  return *p->f;
 }
 
-vector<string> Configuration::GetStrArray(string const & field) const
+vector<string> Configuration::GetStrArray(char const * field) const
 {
-  string const param_str = GetStr(field);
-  return tokenize_str(param_str);
+  Param const * const p = _Find(field);
+  if(!p || !p->str) {
+    ParseError("Unknown string field: " + string(field));
+    exit(-1);
+  }
+  if(!p->str_array_valid) {
+    p->str_array = tokenize_str(*p->str);
+    p->str_array_valid = true;
+  }
+  return p->str_array;
 }
 
-vector<int> Configuration::GetIntArray(string const & field) const
+vector<int> Configuration::GetIntArray(char const * field) const
 {
-  string const param_str = GetStr(field);
-  return tokenize_int(param_str);
+  Param const * const p = _Find(field);
+  if(!p || !p->str) {
+    ParseError("Unknown string field: " + string(field));
+    exit(-1);
+  }
+  if(!p->int_array_valid) {
+    p->int_array = tokenize_int(*p->str);
+    p->int_array_valid = true;
+  }
+  return p->int_array;
 }
 
-vector<double> Configuration::GetFloatArray(string const & field) const
+vector<double> Configuration::GetFloatArray(char const * field) const
 {
-  string const param_str = GetStr(field);
-  return tokenize_float(param_str);
+  Param const * const p = _Find(field);
+  if(!p || !p->str) {
+    ParseError("Unknown string field: " + string(field));
+    exit(-1);
+  }
+  if(!p->float_array_valid) {
+    p->float_array = tokenize_float(*p->str);
+    p->float_array_valid = true;
+  }
+  return p->float_array;
 }
 
 void Configuration::ParseFile(string const & filename)
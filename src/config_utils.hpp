@@ -42,6 +42,36 @@ class Configuration {
   FILE * _config_file;
   string _config_string;
 
+  // One entry per parameter name, resolved from the default maps the first
+  // time a parameter is looked up.  A name may carry several typed values
+  // (e.g. a float and a string holding a per-class array); the pointers 
+  // refer into the maps, so assignments are seen without re-resolving.
+  struct Param {
+    char const * name;
+    string * str;
+    int * i;
+    double * f;
+    // arrays parsed from the string value, valid until it is reassigned
+    mutable bool str_array_valid;
+    mutable bool int_array_valid;
+    mutable bool float_array_valid;
+    mutable vector<string> str_array;
+    mutable vector<int> int_array;
+    mutable vector<double> float_array;
+  };
+
+  // sorted by name
+  mutable vector<Param> _params;
+  mutable size_t _resolved_size;
+
+  // direct-mapped cache from the address of a field name (normally a 
+  // string literal at the call site) to its entry in _params
+  static size_t const LOOKUP_CACHE_SIZE = 1024;
+  mutable vector<pair<char const *, int> > _lookup_cache;
+
+  void _Resolve( ) const;
+  Param const * _Find( char const * field ) const;
+
 protected:
   map<string,string> _str_map;
   map<string,int>    _int_map;
@@ -49,6 +79,8 @@ protected:
   
 public:
   Configuration();
+  Configuration(Configuration const & other);
+  Configuration & operator=(Configuration const & other);
 
   void AddStrField(string const & field, string const & value);
 
@@ -56,13 +88,33 @@ public:
   void Assign(string const & field, int value);
   void Assign(string const & field, double value);
 
-  string GetStr(string const & field) const;
-  int GetInt(string const & field) const;
-  double GetFloat(string const & field) const;
+  string const & GetStr(char const * field) const;
+  int GetInt(char const * field) const;
+  double GetFloat(char const * field) const;
+
+  inline string const & GetStr(string const & field) const {
+    return GetStr(field.c_str());
+  }
+  inline int GetInt(string const & field) const {
+    return GetInt(field.c_str());
+  }
+  inline double GetFloat(string const & field) const {
+    return GetFloat(field.c_str());
+  }
 
-  vector<string> GetStrArray(const string & field) const;
-  vector<int> GetIntArray(const string & field) const;
-  vector<double> GetFloatArray(const string & field) const;
+  vector<string> GetStrArray(char const * field) const;
+  vector<int> GetIntArray(char const * field) const;
+  vector<double> GetFloatArray(char const * field) const;
+
+  inline vector<string> GetStrArray(const string & field) const {
+    return GetStrArray(field.c_str());
+  }
+  inline vector<int> GetIntArray(const string & field) const {
+    return GetIntArray(field.c_str());
+  }
+  inline vector<double> GetFloatArray(const string & field) const {
+    return GetFloatArray(field.c_str());
+  }
 
   void ParseFile(string const & filename);
   void ParseString(string const & str);
@@ -30,11 +30,19 @@
  *A class for credits
  */
 
+#include <cassert>
+#include <pthread.h>
+
 #include "booksim.hpp"
 #include "credit.hpp"
 
 stack<Credit *> Credit::_all;
 stack<Credit *> Credit::_free;
+vector<stack<Credit *> *> Credit::_thread_free;
+__thread stack<Credit *> * Credit::_local_free = NULL;
+
+// guards _all and _thread_free once worker threads allocate credits
+static pthread_mutex_t credit_lock = PTHREAD_MUTEX_INITIALIZER;
 
 Credit::Credit()
 {
@@ -50,20 +58,23 @@ void Credit::Reset()
 }
 
 Credit * Credit::New() {
+  stack<Credit *> & free = _local_free ? *_local_free : _free;
   Credit * c;
-  if(_free.empty()) {
+  if(free.empty()) {
     c = new Credit();
+    pthread_mutex_lock(&credit_lock);
     _all.push(c);
+    pthread_mutex_unlock(&credit_lock);
   } else {
-    c = _free.top();
+    c = free.top();
     c->Reset();
-    _free.pop();
+    free.pop();
   }
   return c;
 }
 
 void Credit::Free() {
-  _free.push(this);
+  (_local_free ? _local_free : &_free)->push(this);
 }
 
 void Credit::FreeAll() {
@@ -71,9 +82,25 @@ void Credit::FreeAll() {
     delete _all.top();
     _all.pop();
   }
+  for(size_t i = 0; i < _thread_free.size(); ++i) {
+    delete _thread_free[i];
+  }
+  _thread_free.clear();
 }
 
-
+// only meaningful while no worker thread is running
 int Credit::OutStanding(){
-  return _all.size()-_free.size();
+  int free = _free.size();
+  for(size_t i = 0; i < _thread_free.size(); ++i) {
+    free += _thread_free[i]->size();
+  }
+  return _all.size()-free;
+}
+
+void Credit::AttachThread() {
+  assert(!_local_free);
+  _local_free = new stack<Credit *>;
+  pthread_mutex_lock(&credit_lock);
+  _thread_free.push_back(_local_free);
+  pthread_mutex_unlock(&credit_lock);
 }
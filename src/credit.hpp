@@ -30,6 +30,7 @@
 
 #include <set>
 #include <stack>
+#include <vector>
 
 class Credit {
 
@@ -47,10 +48,16 @@ public:
   void Free();
   static void FreeAll();
   static int OutStanding();
+
+  // Give the calling thread a free list of its own; used by the threads
+  // of the parallel engine, which allocate and free credits concurrently.
+  static void AttachThread();
 private:
 
   static stack<Credit *> _all;
   static stack<Credit *> _free;
+  static vector<stack<Credit *> *> _thread_free;
+  static __thread stack<Credit *> * _local_free;
 
   Credit();
   ~Credit() {}
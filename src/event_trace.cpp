@@ -0,0 +1,164 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "event_trace.hpp"
+#include "flit.hpp"
+#include "globals.hpp"
+
+char const EventTrace::MAGIC[8] = {'B', 'S', 'E', 'V', 'E', 'N', 'T', 0};
+
+EventTrace::EventTrace( string const & filename, int start, int end )
+  : _filename(filename), _file(NULL), _start(start), _end(end), 
+    _time_offset(0), _last_time(0), _head(0), _tail(0), _records(0), 
+    _stop(false)
+{
+  _file = fopen(filename.c_str(), "wb");
+  if(!_file) {
+    cout << "Error: Unable to open event trace file: " << filename << endl;
+    exit(-1);
+  }
+  char header[HEADER_SIZE];
+  memset(header, 0, sizeof(header));
+  memcpy(header, MAGIC, sizeof(MAGIC));
+  uint32_t const version = VERSION;
+  uint32_t const size = sizeof(EventRecord);
+  memcpy(header + 8, &version, sizeof(version));
+  memcpy(header + 12, &size, sizeof(size));
+  fwrite(header, 1, sizeof(header), _file);
+
+  _ring.resize(RING_CHUNKS);
+  for(size_t i = 0; i < RING_CHUNKS; ++i) {
+    _ring[i].reserve(CHUNK_RECORDS);
+  }
+  pthread_mutex_init(&_lock, NULL);
+  pthread_cond_init(&_not_empty, NULL);
+  pthread_cond_init(&_not_full, NULL);
+  if(pthread_create(&_thread, NULL, &EventTrace::_WriteBehind, this)) {
+    cout << "Error: Unable to start event trace writer thread." << endl;
+    exit(-1);
+  }
+}
+
+EventTrace::~EventTrace( )
+{
+  pthread_mutex_lock(&_lock);
+  if(!_ring[_head % RING_CHUNKS].empty()) {
+    ++_head;
+  }
+  _stop = true;
+  pthread_cond_signal(&_not_empty);
+  pthread_mutex_unlock(&_lock);
+  pthread_join(_thread, NULL);
+  pthread_cond_destroy(&_not_full);
+  pthread_cond_destroy(&_not_empty);
+  pthread_mutex_destroy(&_lock);
+  if(fclose(_file)) {
+    cout << "Error: Unable to write event trace file: " << _filename << endl;
+    exit(-1);
+  }
+}
+
+void EventTrace::Record( int type, Flit const * f, int module, int port, 
+			 int vc, int arg, int aux )
+{
+  int const time = GetSimTime();
+  if((time < _start) || ((_end >= 0) && (time > _end))) {
+    return;
+  }
+  long long t = _time_offset + time;
+  if(t < _last_time) {
+    _time_offset = _last_time - time;
+    t = _last_time;
+  }
+  _last_time = t;
+
+  vector<EventRecord> & chunk = _ring[_head % RING_CHUNKS];
+  chunk.resize(chunk.size() + 1);
+  EventRecord & r = chunk.back();
+  r.time = t;
+  r.flit = f->id;
+  r.packet = f->pid;
+  r.module = module;
+  r.arg = arg;
+  r.port = port;
+  r.vc = vc;
+  r.aux = aux;
+  r.type = type;
+  r.cl = f->cl;
+  ++_records;
+
+  if(chunk.size() >= CHUNK_RECORDS) {
+    _Publish();
+  }
+}
+
+void EventTrace::_Publish( )
+{
+  pthread_mutex_lock(&_lock);
+  ++_head;
+  pthread_cond_signal(&_not_empty);
+  while(_head - _tail >= RING_CHUNKS) {
+    pthread_cond_wait(&_not_full, &_lock);
+  }
+  pthread_mutex_unlock(&_lock);
+}
+
+void * EventTrace::_WriteBehind( void * trace )
+{
+  ((EventTrace *)trace)->_Consume();
+  return NULL;
+}
+
+void EventTrace::_Consume( )
+{
+  while(true) {
+    pthread_mutex_lock(&_lock);
+    while(!_stop && (_tail == _head)) {
+      pthread_cond_wait(&_not_empty, &_lock);
+    }
+    bool const done = (_tail == _head);
+    pthread_mutex_unlock(&_lock);
+    if(done) {
+      break;
+    }
+    vector<EventRecord> & chunk = _ring[_tail % RING_CHUNKS];
+    if(fwrite(&chunk[0], sizeof(EventRecord), chunk.size(), _file) != 
+       chunk.size()) {
+      cout << "Error: Unable to write event trace file: " << _filename << endl;
+      exit(-1);
+    }
+    chunk.clear();
+    pthread_mutex_lock(&_lock);
+    ++_tail;
+    pthread_cond_signal(&_not_full);
+    pthread_mutex_unlock(&_lock);
+  }
+}
@@ -0,0 +1,127 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*event_trace.hpp
+ *
+ *Binary flit event trace.  Modules append fixed-size records for the
+ *main events in a flit's life (injection, routing, VC and switch grants,
+ *link traversal and ejection) to a ring of chunks; full chunks are
+ *written out by a background thread, so the simulator only blocks when
+ *the writer falls a full ring behind.  utils/event2json converts a trace
+ *into Chrome trace (Perfetto) JSON.
+ *
+ *File layout: a 16-byte header (magic, version, record size), followed 
+ *by EventRecords in host byte order.
+ */
+
+#ifndef _EVENT_TRACE_HPP_
+#define _EVENT_TRACE_HPP_
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdint.h>
+#include <pthread.h>
+
+using namespace std;
+
+class Flit;
+
+struct EventRecord {
+  int64_t time;    // cycle, monotonic across back-to-back simulations
+  int32_t flit;
+  int32_t packet;
+  int32_t module;  // router id, or node id for injection and ejection
+  int32_t arg;     // destination node (inject), output port (grants), 
+                   // sink router (link)
+  int16_t port;    // input port (router events), source port (link)
+  int16_t vc;
+  int16_t aux;     // output VC (VC grant), channel latency (link)
+  uint8_t type;
+  uint8_t cl;
+};
+
+class EventTrace {
+
+public:
+
+  enum EventType { INJECT = 0, 
+		   ROUTE, 
+		   VC_GRANT, 
+		   SW_GRANT, 
+		   LINK, 
+		   EJECT, 
+		   NUM_EVENT_TYPES };
+
+  static char const MAGIC[8];
+  static uint32_t const VERSION = 1;
+  static int const HEADER_SIZE = 16;
+
+private:
+
+  static size_t const CHUNK_RECORDS = 16384;
+  static size_t const RING_CHUNKS = 8;
+
+  string _filename;
+  FILE * _file;
+
+  int _start;
+  int _end;
+
+  long long _time_offset;
+  long long _last_time;
+
+  // ring of chunks; the simulator fills _ring[_head], the writer drains 
+  // chunks [_tail, _head)
+  vector<vector<EventRecord> > _ring;
+  size_t _head;
+  size_t _tail;
+  long long _records;
+
+  pthread_t _thread;
+  pthread_mutex_t _lock;
+  pthread_cond_t _not_empty;
+  pthread_cond_t _not_full;
+  bool _stop;
+
+  static void * _WriteBehind( void * trace );
+  void _Consume( );
+  void _Publish( );
+
+public:
+
+  EventTrace( string const & filename, int start = 0, int end = -1 );
+  ~EventTrace( );
+
+  void Record( int type, Flit const * f, int module, int port = -1, 
+	       int vc = -1, int arg = -1, int aux = -1 );
+
+  inline long long NumRecords( ) const { return _records; }
+
+};
+
+#endif
@@ -34,11 +34,22 @@
  *When adding objects make sure to set a default value in this constructor
  */
 
+#include <cassert>
+#include <pthread.h>
+
 #include "booksim.hpp"
 #include "flit.hpp"
 
 stack<Flit *> Flit::_all;
 stack<Flit *> Flit::_free;
+vector<stack<Flit *> *> Flit::_thread_free;
+__thread stack<Flit *> * Flit::_local_free = NULL;
+
+// guards _all, _thread_free and, while worker threads run, _free
+static pthread_mutex_t flit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// flits a worker thread takes from _free at a time
+static size_t const flit_refill = 64;
 
 ostream& operator<<( ostream& os, const Flit& f )
 {
@@ -83,20 +94,33 @@ void Flit::Reset()
 }  
 
 Flit * Flit::New() {
+  stack<Flit *> & free = _local_free ? *_local_free : _free;
+  if(free.empty() && _local_free) {
+    // flits are retired, and freed, by the main thread
+    pthread_mutex_lock(&flit_lock);
+    while(!_free.empty() && (free.size() < flit_refill)) {
+      free.push(_free.top());
+      _free.pop();
+    }
+    pthread_mutex_unlock(&flit_lock);
+  }
   Flit * f;
-  if(_free.empty()) {
+  if(free.empty()) {
     f = new Flit;
+    pthread_mutex_lock(&flit_lock);
     _all.push(f);
+    pthread_mutex_unlock(&flit_lock);
   } else {
-    f = _free.top();
+    f = free.top();
     f->Reset();
-    _free.pop();
+    free.pop();
   }
   return f;
 }
 
+// the main thread only frees flits while the worker threads wait
 void Flit::Free() {
-  _free.push(this);
+  (_local_free ? _local_free : &_free)->push(this);
 }
 
 void Flit::FreeAll() {
@@ -104,4 +128,16 @@ void Flit::FreeAll() {
     delete _all.top();
     _all.pop();
   }
+  for(size_t i = 0; i < _thread_free.size(); ++i) {
+    delete _thread_free[i];
+  }
+  _thread_free.clear();
+}
+
+void Flit::AttachThread() {
+  assert(!_local_free);
+  _local_free = new stack<Flit *>;
+  pthread_mutex_lock(&flit_lock);
+  _thread_free.push_back(_local_free);
+  pthread_mutex_unlock(&flit_lock);
 }
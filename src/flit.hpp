@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <stack>
+#include <vector>
 
 #include "booksim.hpp"
 #include "outputset.hpp"
@@ -89,6 +90,11 @@ public:
   void Free();
   static void FreeAll();
 
+  // Give the calling thread a free list of its own, refilled from the
+  // flits the main thread frees; used by the threads of the parallel 
+  // engine, which generate packets concurrently.
+  static void AttachThread();
+
 private:
 
   Flit();
@@ -96,6 +102,8 @@ private:
 
   static stack<Flit *> _all;
   static stack<Flit *> _free;
+  static vector<stack<Flit *> *> _thread_free;
+  static __thread stack<Flit *> * _local_free;
 
 };
 
@@ -39,6 +39,7 @@
 
 #include "router.hpp"
 #include "globals.hpp"
+#include "event_trace.hpp"
 
 // ----------------------------------------------------------------------
 //  $Author: jbalfour $
@@ -47,8 +48,7 @@
 // ----------------------------------------------------------------------
 FlitChannel::FlitChannel(Module * parent, string const & name, int classes)
 : Channel<Flit>(parent, name), _routerSource(NULL), _routerSourcePort(-1), 
-  _routerSink(NULL), _routerSinkPort(-1), _idle(0) {
-  _active.resize(classes, 0);
+  _routerSink(NULL), _routerSinkPort(-1), _classes(classes), _active(NULL) {
 }
 
 void FlitChannel::SetSource(Router const * const router, int port) {
@@ -61,31 +61,36 @@ void FlitChannel::SetSink(Router const * const router, int port) {
   _routerSinkPort = port;
 }
 
+void FlitChannel::BindActivityCounters(int * counters) {
+  _active = counters;
+}
+
 void FlitChannel::Send(Flit * f) {
   if(f) {
     ++_active[f->cl];
-  } else {
-    ++_idle;
   }
   Channel<Flit>::Send(f);
 }
 
-void FlitChannel::ReadInputs() {
-  Flit const * const & f = _input;
-  if(f && f->watch) {
+void FlitChannel::_Depart(Flit * f) {
+  if(f->watch) {
     *gWatchOut << GetSimTime() << " | " << FullName() << " | "
 	       << "Beginning channel traversal for flit " << f->id
 	       << " with delay " << _delay
 	       << "." << endl;
   }
-  Channel<Flit>::ReadInputs();
+  if(gEventTrace) {
+    gEventTrace->Record(EventTrace::LINK, f, 
+			_routerSource ? _routerSource->GetID() : -1, 
+			_routerSourcePort, f->vc, 
+			_routerSink ? _routerSink->GetID() : -1, _delay);
+  }
 }
 
-void FlitChannel::WriteOutputs() {
-  Channel<Flit>::WriteOutputs();
-  if(_output && _output->watch) {
+void FlitChannel::_Arrive(Flit * f) {
+  if(f->watch) {
     *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-	       << "Completed channel traversal for flit " << _output->id
+	       << "Completed channel traversal for flit " << f->id
 	       << "." << endl;
   }
 }
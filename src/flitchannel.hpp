@@ -68,15 +68,23 @@ public:
   inline int const & GetSinkPort() const {
     return _routerSinkPort;
   }
-  inline vector<int> const & GetActivity() const {
+  inline int NumClasses() const {
+    return _classes;
+  }
+  inline int const * GetActivity() const {
     return _active;
   }
 
+  // Point the per-class flit counters at external storage
+  void BindActivityCounters(int * counters);
+
   // Send flit 
   virtual void Send(Flit * flit);
 
-  virtual void ReadInputs();
-  virtual void WriteOutputs();
+protected:
+
+  virtual void _Depart(Flit * f);
+  virtual void _Arrive(Flit * f);
 
 private:
   
@@ -92,8 +100,8 @@ private:
   int _routerSinkPort;
 
   // Statistics for Activity Factors
-  vector<int> _active;
-  int _idle;
+  int _classes;
+  int * _active;
 };
 
 #endif
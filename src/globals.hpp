@@ -35,9 +35,15 @@
 
 int GetSimTime();
 
+// simulation time of a parallel engine thread; NULL on the main thread,
+// which follows the traffic manager
+extern __thread int const * gThreadTime;
+
 class Stats;
 Stats * GetStats(const std::string & name);
 
+class EventTrace;
+
 extern bool gPrintActivity;
 
 extern int gK;
@@ -48,6 +54,10 @@ extern int gNodes;
 
 extern bool gTrace;
 
+extern bool gProfile;
+
 extern std::ostream * gWatchOut;
 
+extern EventTrace * gEventTrace;
+
 #endif
@@ -53,6 +53,12 @@ void InjectionProcess::reset()
 
 }
 
+void InjectionProcess::set_source_weights(vector<double> const & weights)
+{
+  cout << "Error: Injection process does not support per-source rates." << endl;
+  exit(-1);
+}
+
 InjectionProcess * InjectionProcess::New(string const & inject, int nodes, 
 					 double load, 
 					 Configuration const * const config)
@@ -135,15 +141,28 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
 //=============================================================
 
 BernoulliInjectionProcess::BernoulliInjectionProcess(int nodes, double rate)
-  : InjectionProcess(nodes, rate)
+  : InjectionProcess(nodes, rate), _source_rate(nodes, rate)
 {
 
 }
 
+void BernoulliInjectionProcess::set_source_weights(vector<double> const & weights)
+{
+  assert((int)weights.size() == _nodes);
+  for(int n = 0; n < _nodes; ++n) {
+    double const rate = _rate * weights[n];
+    if(rate > 1.0) {
+      cout << "Warning: Injection rate for source " << n 
+	   << " exceeds 1.0 and will be capped." << endl;
+    }
+    _source_rate[n] = (rate > 1.0) ? 1.0 : rate;
+  }
+}
+
 bool BernoulliInjectionProcess::test(int source)
 {
   assert((source >= 0) && (source < _nodes));
-  return (RandomFloat() < _rate);
+  return (RandomFloat() < _source_rate[source]);
 }
 
 //=============================================================
@@ -41,13 +41,17 @@ public:
   virtual ~InjectionProcess() {}
   virtual bool test(int source) = 0;
   virtual void reset();
+  virtual void set_source_weights(vector<double> const & weights);
   static InjectionProcess * New(string const & inject, int nodes, double load, 
 				Configuration const * const config = NULL);
 };
 
 class BernoulliInjectionProcess : public InjectionProcess {
+private:
+  vector<double> _source_rate;
 public:
   BernoulliInjectionProcess(int nodes, double rate);
+  virtual void set_source_weights(vector<double> const & weights);
   virtual bool test(int source);
 };
 
@@ -53,6 +53,7 @@
 #include "network.hpp"
 #include "injection.hpp"
 #include "power_module.hpp"
+#include "event_trace.hpp"
 
 
 
@@ -63,8 +64,10 @@
  /* the current traffic manager instance */
 TrafficManager * trafficManager = NULL;
 
+__thread int const * gThreadTime = NULL;
+
 int GetSimTime() {
-  return trafficManager->getTime();
+  return gThreadTime ? *gThreadTime : trafficManager->getTime();
 }
 
 class Stats;
@@ -88,8 +91,14 @@ int gNodes;
 //generate nocviewer trace
 bool gTrace;
 
+//time the simulator's own phases
+bool gProfile;
+
 ostream * gWatchOut;
 
+//binary flit event trace
+EventTrace * gEventTrace;
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -169,6 +178,7 @@ int main( int argc, char **argv )
 
   gPrintActivity = (config.GetInt("print_activity") > 0);
   gTrace = (config.GetInt("viewer_trace") > 0);
+  gProfile = (config.GetInt("profile") > 0);
   
   string watch_out_file = config.GetStr( "watch_out" );
   if(watch_out_file == "") {
@@ -178,10 +188,24 @@ int main( int argc, char **argv )
   } else {
     gWatchOut = new ofstream(watch_out_file.c_str());
   }
+
+  string event_trace_file = config.GetStr( "event_trace" );
+  if(event_trace_file == "") {
+    gEventTrace = NULL;
+  } else {
+    gEventTrace = new EventTrace(event_trace_file, 
+				 config.GetInt( "event_trace_start" ), 
+				 config.GetInt( "event_trace_end" ));
+  }
   
 
   /*configure and run the simulator
    */
   bool result = Simulate( config );
+
+  if(gEventTrace) {
+    delete gEventTrace;
+    gEventTrace = NULL;
+  }
   return result ? -1 : 0;
 }
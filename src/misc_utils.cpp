@@ -25,6 +25,9 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cmath>
+#include <cassert>
+
 #include "booksim.hpp"
 #include "misc_utils.hpp"
 
@@ -50,3 +53,53 @@ int log_two( int x )
 
   return r;
 }
+
+// Inverse of the standard normal CDF (Acklam's rational approximation, 
+// relative error below 1.2e-9)
+double normal_quantile( double p )
+{
+  static double const a[] = { -3.969683028665376e+01,  2.209460984245205e+02,
+			      -2.759285104469687e+02,  1.383577518672690e+02,
+			      -3.066479806614716e+01,  2.506628277459239e+00 };
+  static double const b[] = { -5.447609879822406e+01,  1.615858368580409e+02,
+			      -1.556989798598866e+02,  6.680131188771972e+01,
+			      -1.328068155288572e+01 };
+  static double const c[] = { -7.784894002430293e-03, -3.223964580411365e-01,
+			      -2.400758277161838e+00, -2.549732539343734e+00,
+			       4.374664141464968e+00,  2.938163982698783e+00 };
+  static double const d[] = {  7.784695709041462e-03,  3.224671290700398e-01,
+			       2.445134137142996e+00,  3.754408661907416e+00 };
+
+  assert((p > 0.0) && (p < 1.0));
+
+  if(p < 0.02425) {
+    double const q = sqrt(-2.0 * log(p));
+    return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+      ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+  } else if(p > 1.0 - 0.02425) {
+    double const q = sqrt(-2.0 * log(1.0 - p));
+    return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+      ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+  } else {
+    double const q = p - 0.5;
+    double const r = q * q;
+    return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+      (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+  }
+}
+
+// Quantile of Student's t distribution with dof degrees of freedom, using 
+// the Cornish-Fisher expansion around the normal quantile (accurate to 
+// about 1% for dof >= 3)
+double student_t_quantile( double p, int dof )
+{
+  assert(dof > 0);
+  double const z = normal_quantile(p);
+  double const z2 = z * z;
+  double const v = (double)dof;
+  double const g1 = z * (z2 + 1.0) / 4.0;
+  double const g2 = z * ((5.0 * z2 + 16.0) * z2 + 3.0) / 96.0;
+  double const g3 = z * (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) / 384.0;
+  double const g4 = z * ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) / 92160.0;
+  return z + (g1 + (g2 + (g3 + g4 / v) / v) / v) / v;
+}
@@ -30,5 +30,7 @@
 
 int log_two( int x );
 int powi( int x, int y );
+double normal_quantile( double p );
+double student_t_quantile( double p, int dof );
 
 #endif 
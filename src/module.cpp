@@ -33,56 +33,100 @@
  */
 
 #include <iostream>
+#include <sstream>
+#include <set>
 #include <cstdlib>
 
 #include "booksim.hpp"
 #include "module.hpp"
 
+char const * Module::_Intern( const string& kind )
+{
+  // allocated on first use, as modules may be created during static 
+  // initialization; elements of a set never move
+  static set<string> * kinds = new set<string>;
+  return kinds->insert( kind ).first->c_str( );
+}
+
 Module::Module( Module *parent, const string& name )
+  : _parent(parent), _index(-1), _first_child(NULL), _next_sibling(NULL)
 {
-  _name = name;
+  // split off a trailing decimal index, as long as printing it back 
+  // reproduces the name exactly
+  size_t const len = name.size( );
+  size_t start = len;
+  while ( ( start > 0 ) && ( name[start - 1] >= '0' ) && ( name[start - 1] <= '9' ) ) {
+    --start;
+  }
+  size_t const digits = len - start;
+  if ( ( digits > 0 ) && ( digits <= 9 ) && 
+       ( ( digits == 1 ) || ( name[start] != '0' ) ) ) {
+    _kind = _Intern( name.substr( 0, start ) );
+    _index = atoi( name.c_str( ) + start );
+  } else {
+    _kind = _Intern( name );
+  }
 
   if ( parent ) { 
     parent->_AddChild( this );
-    _fullname = parent->_fullname + "/" + name;
-  } else {
-    _fullname = name;
   }
 }
 
 void Module::_AddChild( Module *child )
 {
-  _children.push_back( child );
+  child->_next_sibling = _first_child;
+  _first_child = child;
 }
 
-void Module::DisplayHierarchy( int level, ostream & os ) const
+string Module::Name() const
 {
-  vector<Module *>::const_iterator mod_iter;
+  if ( _index < 0 ) {
+    return _kind;
+  }
+  ostringstream name;
+  name << _kind << _index;
+  return name.str( );
+}
+
+string Module::FullName() const
+{
+  if ( _parent ) {
+    return _parent->FullName( ) + "/" + Name( );
+  }
+  return Name( );
+}
 
+void Module::DisplayHierarchy( int level, ostream & os ) const
+{
   for ( int l = 0; l < level; l++ ) {
     os << "  ";  
   }
 
-  os << _name << endl;
+  os << Name( ) << endl;
 
-  for ( mod_iter = _children.begin( );
-	mod_iter != _children.end( ); mod_iter++ ) {
-    (*mod_iter)->DisplayHierarchy( level + 1 );
+  // children are kept newest first; show them in the order they were added
+  vector<Module const *> children;
+  for ( Module const * child = _first_child; child; child = child->_next_sibling ) {
+    children.push_back( child );
+  }
+  for ( vector<Module const *>::const_reverse_iterator mod_iter = children.rbegin( );
+	mod_iter != children.rend( ); mod_iter++ ) {
+    (*mod_iter)->DisplayHierarchy( level + 1, os );
   }
 }
 
 void Module::Error( const string& msg ) const
 {
-  cout << "Error in " << _fullname << " : " << msg << endl;
+  cout << "Error in " << FullName( ) << " : " << msg << endl;
   exit( -1 );
 }
 
 void Module::Debug( const string& msg ) const
 {
-  cout << "Debug (" << _fullname << ") : " << msg << endl;
+  cout << "Debug (" << FullName( ) << ") : " << msg << endl;
 }
 
 void Module::Display( ostream & os ) const 
 {
-  os << "Display method not implemented for " << _fullname << endl;
+  os << "Display method not implemented for " << FullName( ) << endl;
 }
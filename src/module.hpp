@@ -36,10 +36,18 @@
 
 class Module {
 private:
-  string _name;
-  string _fullname;
+  // Names are not stored as strings: a module keeps an interned kind and
+  // an optional index (-1 if none), e.g. "vc_" and 3 for "vc_3", and both
+  // the name and the hierarchical full name are built on demand.
+  Module * _parent;
+  char const * _kind;
+  int _index;
 
-  vector<Module *> _children;
+  // children, most recently added first
+  Module * _first_child;
+  Module * _next_sibling;
+
+  static char const * _Intern( const string& kind );
 
 protected:
   void _AddChild( Module *child );
@@ -48,8 +56,8 @@ public:
   Module( Module *parent, const string& name );
   virtual ~Module( ) { }
   
-  inline const string & Name() const { return _name; }
-  inline const string & FullName() const { return _fullname; }
+  string Name() const;
+  string FullName() const;
 
   void DisplayHierarchy( int level = 0, ostream & os = cout ) const;
 
@@ -51,29 +51,45 @@
  */
 
 #include "anynet.hpp"
+#include "random_utils.hpp"
 #include <fstream>
 #include <sstream>
 #include <limits>
 #include <algorithm>
+#include <queue>
+#include <functional>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ctime>
 //this is a hack, I can't easily get the routing talbe out of the network
-map<int, int>* global_routing_table;
+int const * global_routing_table;
+int const * global_multipath_table;
+int const * global_multipath_begin;
+int const * global_multipath_sets;
 
 AnyNet::AnyNet( const Configuration &config, const string & name )
-  :  Network( config, name ){
+  :  Network( config, name ), table(NULL), multipath(NULL), 
+     cache_map(NULL), cache_bytes(0){
 
   router_list.resize(2);
+  route_threads = config.GetInt("route_threads");
+  use_multipath = (config.GetStr("routing_function").compare(0, 5, "ecmp_") == 0);
+  multipath_slack = use_multipath ? config.GetInt("multipath_slack") : -1;
+  use_cache = (config.GetInt("network_cache") > 0);
+  cache_dir = config.GetStr("network_cache_dir");
   _ComputeSize( config );
   _Alloc( );
   _BuildNet( config );
 }
 
 AnyNet::~AnyNet(){
-  for(int i = 0; i < 2; ++i) {
-    for(map<int, map<int, pair<int,int> > >::iterator iter = router_list[i].begin();
-	iter != router_list[i].end();
-	++iter) {
-      iter->second.clear();
-    }
+  if(cache_map){
+    munmap(cache_map, cache_bytes);
   }
 }
 
@@ -83,68 +99,60 @@ void AnyNet::_ComputeSize( const Configuration &config ){
     cout<<"No network file name provided"<<endl;
     exit(-1);
   }
-  //parse the network description file
-  readFile();
+  //parse the network description file, unless an up to date binary copy of
+  //it and of its routing table is available
+  if(!use_cache || !loadCache()){
+    readFile();
+    buildGraph();
+  }
+  _size = adj_begin.size()-1;
+  _nodes = node_begin[_size];
+  _channels = adj_begin[_size];
 
-  _channels =0;
   cout<<"========================Network File Parsed=================\n";
   cout<<"******************node listing**********************\n";
-  map<int,  int >::iterator iter;
-  for(iter = node_list.begin(); iter!=node_list.end(); iter++){
-    cout<<"Node "<<iter->first;
-    cout<<"\tRouter "<<iter->second<<endl;
+  vector<int> node_router(_nodes);
+  for(int r = 0; r<_size; r++){
+    for(int e = node_begin[r]; e<node_begin[r+1]; e++){
+      node_router[node_id[e]] = r;
+    }
+  }
+  for(int n = 0; n<_nodes; n++){
+    cout<<"Node "<<n;
+    cout<<"\tRouter "<<node_router[n]<<endl;
   }
 
-  map<int,   map<int, pair<int,int> > >::iterator iter3;
   cout<<"\n****************router to node listing*************\n";
-  for(iter3 = router_list[0].begin(); iter3!=router_list[0].end(); iter3++){
-    cout<<"Router "<<iter3->first<<endl;
-    map<int, pair<int,int> >::iterator iter2;
-    for(iter2 = iter3->second.begin(); 
-	iter2!=iter3->second.end(); 
-	iter2++){
-      cout<<"\t Node "<<iter2->first<<" lat "<<iter2->second.second<<endl;
+  for(int r = 0; r<_size; r++){
+    cout<<"Router "<<r<<endl;
+    for(int e = node_begin[r]; e<node_begin[r+1]; e++){
+      cout<<"\t Node "<<node_id[e]<<" lat "<<node_latency[e]<<endl;
     }
   }
 
   cout<<"\n*****************router to router listing************\n";
-  for(iter3 = router_list[1].begin(); iter3!=router_list[1].end(); iter3++){
-    cout<<"Router "<<iter3->first<<endl;
-    map<int, pair<int,int> >::iterator iter2;
-    if(iter3->second.size() == 0){
-      cout<<"Caution Router "<<iter3->first
+  for(int r = 0; r<_size; r++){
+    cout<<"Router "<<r<<endl;
+    if(adj_begin[r] == adj_begin[r+1]){
+      cout<<"Caution Router "<<r
 	  <<" is not connected to any other Router\n"<<endl;
     }
-    for(iter2 = iter3->second.begin(); 
-	iter2!=iter3->second.end(); 
-	iter2++){
-      cout<<"\t Router "<<iter2->first<<" lat "<<iter2->second.second<<endl;
-      _channels++;
+    for(int e = adj_begin[r]; e<adj_begin[r+1]; e++){
+      cout<<"\t Router "<<adj_router[e]<<" lat "<<adj_latency[e]<<endl;
     }
   }
-
-  _size = router_list[1].size();
-  _nodes = node_list.size();
-
 }
 
 
 
 void AnyNet::_BuildNet( const Configuration &config ){
-  
-
-  //I need to keep track the output ports for each router during build
-  int * outport = (int*)malloc(sizeof(int)*_size);
-  for(int i = 0; i<_size; i++){outport[i] = 0;}
 
   cout<<"==========================Node to Router =====================\n";
   //adding the injection/ejection chanenls first
-  map<int,   map<int, pair<int,int> > >::iterator niter;
-  for(niter = router_list[0].begin(); niter!=router_list[0].end(); niter++){
-    map<int,   map<int, pair<int,int> > >::iterator riter = router_list[1].find(niter->first);
+  for(int node = 0; node<_size; node++){
     //calculate radix
-    int radix = niter->second.size()+riter->second.size();
-    int node = niter->first;
+    int radix = (node_begin[node+1]-node_begin[node]) +
+      (adj_begin[node+1]-adj_begin[node]);
     cout<<"router "<<node<<" radix "<<radix<<endl;
     //decalre the routers 
     ostringstream router_name;
@@ -154,18 +162,14 @@ void AnyNet::_BuildNet( const Configuration &config ){
     					node, radix, radix );
     _timed_modules.push_back(_routers[node]);
     //add injeciton ejection channels
-    map<int, pair<int,int> >::iterator nniter;
-    for(nniter = niter->second.begin();nniter!=niter->second.end(); nniter++){
-      int link = nniter->first;
-      //add the outport port assined to the map
-      (niter->second)[link].first = outport[node];
-      outport[node]++;
-      cout<<"\t connected to node "<<link<<" at outport "<<nniter->second.first
-	  <<" lat "<<nniter->second.second<<endl;
-      _inject[link]->SetLatency(nniter->second.second);
-      _inject_cred[link]->SetLatency(nniter->second.second);
-      _eject[link]->SetLatency(nniter->second.second);
-      _eject_cred[link]->SetLatency(nniter->second.second);
+    for(int e = node_begin[node]; e<node_begin[node+1]; e++){
+      int link = node_id[e];
+      cout<<"\t connected to node "<<link<<" at outport "<<node_port[e]
+	  <<" lat "<<node_latency[e]<<endl;
+      _inject[link]->SetLatency(node_latency[e]);
+      _inject_cred[link]->SetLatency(node_latency[e]);
+      _eject[link]->SetLatency(node_latency[e]);
+      _eject_cred[link]->SetLatency(node_latency[e]);
 
       _routers[node]->AddInputChannel( _inject[link], _inject_cred[link] );
       _routers[node]->AddOutputChannel( _eject[link], _eject_cred[link] );
@@ -175,51 +179,48 @@ void AnyNet::_BuildNet( const Configuration &config ){
 
   cout<<"==========================Router to Router =====================\n";
   //add inter router channels
-  //since there is no way to systematically number the channels we just start from 0
-  //the map, is a mapping of output->input
-  int channel_count = 0; 
-  for(niter = router_list[0].begin(); niter!=router_list[0].end(); niter++){
-    map<int,   map<int, pair<int,int> > >::iterator riter = router_list[1].find(niter->first);
-    int node = niter->first;
-    map<int, pair<int,int> >::iterator rriter;
+  //since there is no way to systematically number the channels, they are
+  //numbered in the order of the link array
+  for(int node = 0; node<_size; node++){
     cout<<"router "<<node<<endl;
-    for(rriter = riter->second.begin();rriter!=riter->second.end(); rriter++){
-      int other_node = rriter->first;
-      int link = channel_count;
-      //add the outport port assined to the map
-      (riter->second)[other_node].first = outport[node];
-      outport[node]++;
+    for(int link = adj_begin[node]; link<adj_begin[node+1]; link++){
+      int other_node = adj_router[link];
       cout<<"\t connected to router "<<other_node<<" using link "<<link
-	  <<" at outport "<<rriter->second.first
-	  <<" lat "<<rriter->second.second<<endl;
+	  <<" at outport "<<adj_port[link]
+	  <<" lat "<<adj_latency[link]<<endl;
 
-      _chan[link]->SetLatency(rriter->second.second);
-      _chan_cred[link]->SetLatency(rriter->second.second);
+      _chan[link]->SetLatency(adj_latency[link]);
+      _chan_cred[link]->SetLatency(adj_latency[link]);
 
       _routers[node]->AddOutputChannel( _chan[link], _chan_cred[link] );
       _routers[other_node]->AddInputChannel( _chan[link], _chan_cred[link]);
-      channel_count++;
     }
   }
 
-  buildRoutingTable();
+  if(!table){
+    buildRoutingTable();
+    if(use_cache){
+      writeCache();
+    }
+  }
+  global_routing_table = table;
+  if(use_multipath){
+    global_multipath_table = multipath;
+    global_multipath_begin = &multipath_begin[0];
+    global_multipath_sets = &multipath_sets[0];
+  }
 
 }
 
 
 void AnyNet::RegisterRoutingFunctions() {
   gRoutingFunctionMap["min_anynet"] = &min_anynet;
+  gRoutingFunctionMap["ecmp_random_anynet"] = &ecmp_random_anynet;
+  gRoutingFunctionMap["ecmp_hash_anynet"] = &ecmp_hash_anynet;
+  gRoutingFunctionMap["ecmp_adaptive_anynet"] = &ecmp_adaptive_anynet;
 }
 
-void min_anynet( const Router *r, const Flit *f, int in_channel, 
-		 OutputSet *outputs, bool inject ){
-  int out_port=-1;
-  if(!inject){
-    assert(global_routing_table[r->GetID()].count(f->dest)!=0);
-    out_port=global_routing_table[r->GetID()][f->dest];
-  }
- 
-
+static void anynet_route( const Flit *f, int out_port, OutputSet *outputs ){
   int vcBegin = 0, vcEnd = gNumVCs-1;
   if ( f->type == Flit::READ_REQUEST ) {
     vcBegin = gReadReqBeginVC;
@@ -240,84 +241,498 @@ void min_anynet( const Router *r, const Flit *f, int in_channel,
   outputs->AddRange( out_port , vcBegin, vcEnd );
 }
 
+void min_anynet( const Router *r, const Flit *f, int in_channel, 
+		 OutputSet *outputs, bool inject ){
+  int out_port=-1;
+  if(!inject){
+    out_port=global_routing_table[r->GetID()*gNodes+f->dest];
+    assert(out_port!=-1);
+  }
+  anynet_route(f, out_port, outputs);
+}
+
+//candidate ports towards the flit's destination, as a count followed by the ports
+static int const * anynet_ports( const Router *r, const Flit *f ){
+  int const offset = global_multipath_table[r->GetID()*gNodes+f->dest];
+  assert(offset!=-1);
+  return global_multipath_sets + global_multipath_begin[r->GetID()] + offset;
+}
+
+//a new choice for every packet at every hop
+void ecmp_random_anynet( const Router *r, const Flit *f, int in_channel, 
+			 OutputSet *outputs, bool inject ){
+  int out_port=-1;
+  if(!inject){
+    int const * ports = anynet_ports(r, f);
+    out_port = ports[1+RandomInt(ports[0]-1)];
+  }
+  anynet_route(f, out_port, outputs);
+}
+
+//all packets between the same source and destination take the same path
+void ecmp_hash_anynet( const Router *r, const Flit *f, int in_channel, 
+		       OutputSet *outputs, bool inject ){
+  int out_port=-1;
+  if(!inject){
+    int const * ports = anynet_ports(r, f);
+    //the router is part of the hash, so that flows sharing a choice at one
+    //router do not keep sharing it further on
+    unsigned int hash = (unsigned int)f->src * 2654435761U;
+    hash ^= (unsigned int)f->dest + 0x9e3779b9U + (hash << 6) + (hash >> 2);
+    hash ^= (unsigned int)r->GetID() + 0x9e3779b9U + (hash << 6) + (hash >> 2);
+    out_port = ports[1+(hash % ports[0])];
+  }
+  anynet_route(f, out_port, outputs);
+}
+
+//the candidate with the fewest used downstream credits, the first one on ties
+void ecmp_adaptive_anynet( const Router *r, const Flit *f, int in_channel, 
+			   OutputSet *outputs, bool inject ){
+  int out_port=-1;
+  if(!inject){
+    int const * ports = anynet_ports(r, f);
+    out_port = ports[1];
+    int min_credit = r->GetUsedCredit(out_port);
+    for(int i = 2; i<=ports[0]; i++){
+      int const credit = r->GetUsedCredit(ports[i]);
+      if(credit < min_credit){
+	min_credit = credit;
+	out_port = ports[i];
+      }
+    }
+  }
+  anynet_route(f, out_port, outputs);
+}
+
+//output ports are numbered with the ejection channels first, followed by
+//the router to router channels, both in order of the attached node/router
+void AnyNet::buildGraph(){
+  int const size = router_list[1].size();
+  adj_begin.assign(size+1, 0);
+  node_begin.assign(size+1, 0);
+  for(int r = 0; r<size; r++){
+    adj_begin[r+1] = adj_begin[r] + router_list[1][r].size();
+    node_begin[r+1] = node_begin[r] + router_list[0][r].size();
+  }
+  adj_router.resize(adj_begin[size]);
+  adj_latency.resize(adj_begin[size]);
+  adj_port.resize(adj_begin[size]);
+  node_id.resize(node_begin[size]);
+  node_latency.resize(node_begin[size]);
+  node_port.resize(node_begin[size]);
+  for(int r = 0; r<size; r++){
+    int port = 0;
+    int e = node_begin[r];
+    for(map<int, pair<int,int> >::const_iterator iter = router_list[0][r].begin();
+	iter!=router_list[0][r].end();
+	iter++, e++){
+      node_id[e] = iter->first;
+      node_latency[e] = iter->second.second;
+      node_port[e] = port++;
+    }
+    e = adj_begin[r];
+    for(map<int, pair<int,int> >::const_iterator iter = router_list[1][r].begin();
+	iter!=router_list[1][r].end();
+	iter++, e++){
+      adj_router[e] = iter->first;
+      adj_latency[e] = iter->second.second;
+      adj_port[e] = port++;
+    }
+  }
+  link_up.assign(adj_begin[size], 1);
+  //the parsed maps are not needed anymore
+  router_list[0].clear();
+  router_list[1].clear();
+  node_list.clear();
+}
+
+//every stride-th router of route_sources, starting from first; shortest
+//paths are searched in the first phase, multipath sets collected in the second
+struct RouteShare {
+  AnyNet * net;
+  int phase;
+  int first;
+  int stride;
+};
+
+void * AnyNet::routeThread(void * arg){
+  RouteShare const * share = (RouteShare const *)arg;
+  AnyNet * net = share->net;
+  vector<int> dist;
+  vector<int> hop;
+  vector<int> via;
+  map<vector<int>, int> interned;
+  int const count = net->route_sources.size();
+  for(int i = share->first; i<count; i+=share->stride){
+    int const r = net->route_sources[i];
+    if(share->phase == 0){
+      net->route(r, dist, hop, via);
+    } else {
+      net->collectPorts(r, hop, interned);
+    }
+  }
+  return NULL;
+}
+
+void AnyNet::runThreads(int phase){
+  //sources are independent, so they are spread over threads
+  int threads = route_threads;
+  if(threads<=0){
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  threads = max(1, min(threads, (int)route_sources.size()));
+  vector<RouteShare> shares(threads);
+  vector<pthread_t> workers(threads);
+  vector<bool> started(threads, false);
+  for(int t = 0; t<threads; t++){
+    shares[t].net = this;
+    shares[t].phase = phase;
+    shares[t].first = t;
+    shares[t].stride = threads;
+    if(t>0){
+      started[t] = (pthread_create(&workers[t], NULL, &AnyNet::routeThread, &shares[t])==0);
+    }
+  }
+  for(int t = 0; t<threads; t++){
+    if(started[t]){
+      pthread_join(workers[t], NULL);
+    } else {
+      routeThread(&shares[t]);
+    }
+  }
+}
+
 void AnyNet::buildRoutingTable(){
   cout<<"========================== Routing table  =====================\n";  
-  routing_table.resize(_size);
-  for(int i = 0; i<_size; i++){
-    route(i);
+  routing_table.assign(_size*_nodes, -1);
+  table = &routing_table[0];
+  if(use_multipath){
+    distances.assign((size_t)_size*_size, numeric_limits<int>::max());
+  }
+  route_sources.resize(_size);
+  for(int r = 0; r<_size; r++){
+    route_sources[r] = r;
+  }
+  runThreads(0);
+
+  if(use_multipath){
+    buildMultipath();
+    vector<int>().swap(distances);
   }
-  global_routing_table = &routing_table[0];
 }
 
+//collects the port sets of the routers in route_sources; the sets of the
+//other routers are kept
+void AnyNet::buildMultipath(){
+  if(multipath_table.empty()){
+    multipath_table.assign(_size*_nodes, -1);
+  }
+  multipath = &multipath_table[0];
+  router_sets.assign(_size, vector<int>());
+  vector<bool> collected(_size, false);
+  for(size_t i = 0; i<route_sources.size(); i++){
+    collected[route_sources[i]] = true;
+  }
+  runThreads(1);
+  vector<int> begin(_size+1, 0);
+  for(int r = 0; r<_size; r++){
+    begin[r+1] = begin[r] + (collected[r] ? (int)router_sets[r].size() :
+			     (multipath_begin[r+1] - multipath_begin[r]));
+  }
+  vector<int> sets;
+  sets.reserve(begin[_size]);
+  for(int r = 0; r<_size; r++){
+    if(collected[r]){
+      sets.insert(sets.end(), router_sets[r].begin(), router_sets[r].end());
+    } else {
+      sets.insert(sets.end(), multipath_sets.begin() + multipath_begin[r], 
+		  multipath_sets.begin() + multipath_begin[r+1]);
+    }
+  }
+  multipath_sets.swap(sets);
+  multipath_begin.swap(begin);
+  vector<vector<int> >().swap(router_sets);
+}
 
-//11/7/2012
-//basically djistra's, tested on a large dragonfly anynet configuration
-void AnyNet::route(int r_start){
-  int* dist = new int[_size];
-  int* prev = new int[_size];
-  set<int> rlist;
-  for(int i = 0; i<_size; i++){
-    dist[i] =  numeric_limits<int>::max();
-    prev[i] = -1;
-    rlist.insert(i);
+//a port leads towards a destination router if the neighbor behind it is
+//strictly closer to it, and the path through it is at most multipath_slack
+//cycles longer than the shortest one; with no slack these are exactly the
+//first hops of all shortest paths. Requiring progress keeps the near-minimal
+//paths free of loops. Distinct port sets are stored once per router.
+static int internPorts(vector<int> const & ports, map<vector<int>, int> & interned,
+		       vector<int> & sets){
+  map<vector<int>, int>::iterator iter = interned.find(ports);
+  if(iter == interned.end()){
+    iter = interned.insert(make_pair(ports, (int)sets.size())).first;
+    sets.push_back(ports.size());
+    sets.insert(sets.end(), ports.begin(), ports.end());
   }
-  dist[r_start] = 0;
-  while(!rlist.empty()){
-    //find min 
-    int min_dist = numeric_limits<int>::max();
-    int min_cand = -1;
-    for(set<int>::iterator i = rlist.begin();
-	i!=rlist.end();
-	i++){
-      if(dist[*i]<min_dist){
-	min_dist = dist[*i];
-	min_cand = *i;
+  return iter->second;
+}
+
+void AnyNet::collectPorts(int r_start, vector<int> & ports, 
+			  map<vector<int>, int> & interned){
+  interned.clear();
+  vector<int> & sets = router_sets[r_start];
+  int * const row = &multipath_table[r_start*_nodes];
+  fill(row, row+_nodes, -1);
+  int const * const dist = &distances[(size_t)r_start*_size];
+  for(int t = 0; t<_size; t++){
+    ports.clear();
+    if(t == r_start){
+      for(int e = node_begin[t]; e<node_begin[t+1]; e++){
+	ports.assign(1, node_port[e]);
+	row[node_id[e]] = internPorts(ports, interned, sets);
       }
+      continue;
+    }
+    if(dist[t] == numeric_limits<int>::max()){
+      continue; //unreachable
     }
-    rlist.erase(min_cand);
+    for(int l = adj_begin[r_start]; l<adj_begin[r_start+1]; l++){
+      if(!link_up[l]){
+	continue;
+      }
+      int const next = distances[(size_t)adj_router[l]*_size+t];
+      if(next < dist[t] && adj_latency[l] + next <= dist[t] + multipath_slack){
+	ports.push_back(adj_port[l]);
+      }
+    }
+    int const offset = internPorts(ports, interned, sets);
+    for(int e = node_begin[t]; e<node_begin[t+1]; e++){
+      row[node_id[e]] = offset;
+    }
+  }
+}
 
-    //neighbor
-    for(map<int,pair<int,int> >::iterator i = router_list[1][min_cand].begin(); 
-	i!=router_list[1][min_cand].end(); 
-	i++){
-      int new_dist = dist[min_cand] + i->second.second;//distance is hops not cycles
-      if(new_dist < dist[i->first]){
-	dist[i->first] = new_dist;
-	prev[i->first] = min_cand;
+
+//router whose output a link is
+int AnyNet::linkSource(int link) const {
+  return upper_bound(adj_begin.begin(), adj_begin.end(), link) - adj_begin.begin() - 1;
+}
+
+//rerouting after a link changes state needs the distances and shortest path
+//trees of all sources, which are only kept once the first link fails; the
+//search is repeated here because the tables may have come from the cache
+void AnyNet::trackFaults(){
+  if(!tree_links.empty()){
+    return;
+  }
+  routing_table.assign(_size*_nodes, -1);
+  table = &routing_table[0];
+  if(use_multipath && multipath_table.empty()){
+    //the port sets from the cache are updated in place from now on
+    multipath_table.assign(multipath, multipath+_size*_nodes);
+    multipath = &multipath_table[0];
+  }
+  distances.assign((size_t)_size*_size, numeric_limits<int>::max());
+  tree_links.assign((size_t)_size*_size, -1);
+  route_sources.resize(_size);
+  for(int r = 0; r<_size; r++){
+    route_sources[r] = r;
+  }
+  runThreads(0);
+}
+
+//only sources whose routes change are searched again. A failed link
+//matters to a source whose shortest path tree contains it, and a restored
+//link to one where it gives a shorter path, or an equally short one through
+//a router the search visits before the current one. Every other source
+//would get exactly the same tree from a full rebuild.
+//returns false if the change leaves some node unreachable from a router
+//that could reach it before
+bool AnyNet::setLinkState( int r, int c, bool fault ){
+  Network::OutChannelFault(r, c, fault);
+  int const ejection_ports = node_begin[r+1]-node_begin[r];
+  if(c < ejection_ports || c >= ejection_ports + adj_begin[r+1]-adj_begin[r]){
+    Error("Anynet: only channels between routers can fail");
+  }
+  int const link = adj_begin[r] + c - ejection_ports;
+  if(link_up[link] == !fault){
+    return true;
+  }
+  trackFaults();
+  link_up[link] = !fault;
+
+  int const other = adj_router[link];
+  route_sources.clear();
+  for(int x = 0; x<_size; x++){
+    int const * const dist = &distances[(size_t)x*_size];
+    if(fault){
+      if(tree_links[(size_t)x*_size+other] == link){
+	route_sources.push_back(x);
+      }
+    } else if(dist[r] != numeric_limits<int>::max() && other != x){
+      int const new_dist = dist[r] + adj_latency[link];
+      int const parent = (tree_links[(size_t)x*_size+other] == -1) ? -1 :
+	linkSource(tree_links[(size_t)x*_size+other]);
+      if(new_dist < dist[other] ||
+	 (new_dist == dist[other] && make_pair(dist[r], r) < make_pair(dist[parent], parent))){
+	route_sources.push_back(x);
       }
     }
   }
-  
-  //post process from the prev list
-  for(int i = 0; i<_size; i++){
-    if(prev[i] ==-1){ //self
-      assert(i == r_start);
-      for(map<int, pair<int, int> >::iterator iter = router_list[0][i].begin();
-	  iter!=router_list[0][i].end();
-	  iter++){
-	routing_table[r_start][iter->first]=iter->second.first;
-	//cout<<"node "<<iter->first<<" port "<< iter->second.first<<endl;
+  cout<<"Anynet:channel from router "<<r<<" to router "<<other
+      <<(fault ? " failed" : " restored")<<", rerouting "
+      <<route_sources.size()<<" of "<<_size<<" routers"<<endl;
+  //distance rows of the sources before the search, to tell which change
+  vector<int> old_dist;
+  if(use_multipath){
+    old_dist.reserve(route_sources.size()*_size);
+    for(size_t i = 0; i<route_sources.size(); i++){
+      size_t const x = route_sources[i];
+      old_dist.insert(old_dist.end(), distances.begin() + x*_size, 
+		      distances.begin() + (x+1)*_size);
+    }
+  }
+  //nodes each source reaches before the search, to detect a partition
+  vector<int> reachable(route_sources.size());
+  for(size_t i = 0; i<route_sources.size(); i++){
+    int const * const row = &routing_table[route_sources[i]*_nodes];
+    reachable[i] = _nodes - count(row, row+_nodes, -1);
+  }
+  if(!route_sources.empty()){
+    runThreads(0);
+  }
+  bool connected = true;
+  for(size_t i = 0; connected && i<route_sources.size(); i++){
+    int const * const row = &routing_table[route_sources[i]*_nodes];
+    connected = (_nodes - count(row, row+_nodes, -1) == reachable[i]);
+  }
+  if(use_multipath){
+    //the port sets of a router depend only on its links and on its own
+    //distances and those of its neighbors, so only routers with a changed
+    //row, a changed neighbor row or the changed link are collected again
+    vector<bool> changed(_size, false);
+    for(size_t i = 0; i<route_sources.size(); i++){
+      size_t const x = route_sources[i];
+      changed[x] = !equal(distances.begin() + x*_size, distances.begin() + (x+1)*_size,
+			  old_dist.begin() + i*_size);
+    }
+    route_sources.clear();
+    for(int x = 0; x<_size; x++){
+      bool collect = changed[x] || x == r;
+      for(int l = adj_begin[x]; !collect && l<adj_begin[x+1]; l++){
+	collect = changed[adj_router[l]];
+      }
+      if(collect){
+	route_sources.push_back(x);
       }
+    }
+    cout<<"Anynet:collecting port sets of "<<route_sources.size()<<" of "
+	<<_size<<" routers"<<endl;
+    buildMultipath();
+    global_multipath_table = multipath;
+    global_multipath_begin = &multipath_begin[0];
+    global_multipath_sets = &multipath_sets[0];
+  }
+  global_routing_table = table;
+  return connected;
+}
+
+void AnyNet::OutChannelFault( int r, int c, bool fault ){
+  if(!setLinkState(r, c, fault)){
+    ostringstream err;
+    err << "Anynet: failing the channel from router " << r << " to router "
+	<< adj_router[adj_begin[r] + c - (node_begin[r+1]-node_begin[r])]
+	<< " disconnects the network";
+    Error(err.str());
+  }
+}
+
+void AnyNet::InsertRandomFaults( const Configuration &config ){
+  int num_fails = config.GetInt( "link_failures" );
+  if(num_fails > _channels){
+    Error("Anynet: more link failures than channels between routers");
+  }
+  vector<long> save_x;
+  vector<double> save_u;
+  SaveRandomState( save_x, save_u );
+  int fail_seed;
+  if ( config.GetStr( "fail_seed" ) == "time" ) {
+    fail_seed = int( time( NULL ) );
+    cout << "SEED: fail_seed=" << fail_seed << endl;
+  } else {
+    fail_seed = config.GetInt( "fail_seed" );
+  }
+  RandomSeed( fail_seed );
+
+  //distinct links, by a partial shuffle; a link whose failure would
+  //disconnect the network is restored and another one drawn instead
+  vector<int> links(_channels);
+  for(int l = 0; l<_channels; l++){
+    links[l] = l;
+  }
+  int failed = 0;
+  for(int i = 0; failed<num_fails; i++){
+    if(i == _channels){
+      Error("Anynet: link_failures cannot be met without disconnecting the network");
+    }
+    swap(links[i], links[i+RandomInt(_channels-i-1)]);
+    int const r = linkSource(links[i]);
+    if(setLinkState(r, adj_port[links[i]], true)){
+      failed++;
     } else {
-      int distance=0;
-      int neighbor=i;
-      while(prev[neighbor]!=r_start){
-	assert(router_list[1][neighbor].count(prev[neighbor])>0);
-	distance+=router_list[1][prev[neighbor]][neighbor].second;//REVERSE lat
-	neighbor= prev[neighbor];
+      cout<<"Anynet:keeping channel from router "<<r<<" to router "
+	  <<adj_router[links[i]]<<", its failure disconnects the network"<<endl;
+      setLinkState(r, adj_port[links[i]], false);
+    }
+  }
+
+  RestoreRandomState( save_x, save_u );
+}
+
+//11/7/2012
+//basically djistra's, tested on a large dragonfly anynet configuration
+//the heap orders candidates by (distance, router), so ties resolve towards the
+//lower router id exactly like the original linear minimum scan
+void AnyNet::route(int r_start, vector<int> & dist, vector<int> & hop, 
+		   vector<int> & via){
+  dist.assign(_size, numeric_limits<int>::max());
+  //output port at r_start of the first hop towards each router
+  hop.assign(_size, -1);
+  //link over which each router is reached
+  via.assign(_size, -1);
+  priority_queue<pair<int,int>, vector<pair<int,int> >, greater<pair<int,int> > > pending;
+  dist[r_start] = 0;
+  pending.push(make_pair(0, r_start));
+  while(!pending.empty()){
+    int const min_dist = pending.top().first;
+    int const min_cand = pending.top().second;
+    pending.pop();
+    if(min_dist > dist[min_cand]){
+      continue; //stale entry
+    }
+
+    //neighbor
+    for(int e = adj_begin[min_cand]; e<adj_begin[min_cand+1]; e++){
+      if(!link_up[e]){
+	continue;
       }
-      distance+=router_list[1][prev[neighbor]][neighbor].second;//lat
-
-      assert( router_list[1][r_start].count(neighbor)!=0);
-      int port = router_list[1][r_start][neighbor].first;
-      for(map<int, pair<int,int> >::iterator iter = router_list[0][i].begin();
-	  iter!=router_list[0][i].end();
-	  iter++){
-	routing_table[r_start][iter->first]=port;
-	//cout<<"node "<<iter->first<<" port "<< port<<" dist "<<distance<<endl;
+      int const neighbor = adj_router[e];
+      int new_dist = min_dist + adj_latency[e];//distance is cycles not hops
+      if(new_dist < dist[neighbor]){
+	dist[neighbor] = new_dist;
+	hop[neighbor] = (min_cand == r_start) ? adj_port[e] : hop[min_cand];
+	via[neighbor] = e;
+	pending.push(make_pair(new_dist, neighbor));
       }
     }
   }
+  
+  if(!distances.empty()){
+    copy(dist.begin(), dist.end(), distances.begin() + (size_t)r_start*_size);
+  }
+  if(!tree_links.empty()){
+    copy(via.begin(), via.end(), tree_links.begin() + (size_t)r_start*_size);
+  }
+  
+  int * const row = &routing_table[r_start*_nodes];
+  for(int i = 0; i<_size; i++){
+    for(int e = node_begin[i]; e<node_begin[i+1]; e++){
+      row[node_id[e]] = (i == r_start) ? node_port[e] : hop[i];
+    }
+  }
 }
 
 
@@ -499,3 +914,153 @@ void AnyNet::readFile(){
   
 }
 
+
+//the cache holds the link arrays, the routing table and, if present, the
+//multipath tables, in this order, after a header identifying the network file
+//contents they were derived from
+struct AnyNetCacheHeader {
+  char magic[8];
+  unsigned long long version;
+  unsigned long long hash;
+  int size;
+  int nodes;
+  int links;
+  int slack; //-1 without multipath tables
+  int sets;
+  int unused;
+};
+
+static char const anynet_cache_magic[8] = {'B','S','A','N','Y','N','E','T'};
+static unsigned long long const anynet_cache_version = 2;
+
+string AnyNet::cacheFile() const {
+  string name = file_name;
+  if(cache_dir != ""){
+    size_t slash = name.rfind('/');
+    if(slash != string::npos){
+      name = name.substr(slash+1);
+    }
+    name = cache_dir + "/" + name;
+  }
+  return name + ".cache";
+}
+
+//64-bit FNV-1a of the network file
+unsigned long long AnyNet::fileHash() const {
+  unsigned long long hash = 14695981039346656037ULL;
+  ifstream network_list(file_name.c_str(), ios::in | ios::binary);
+  char buffer[65536];
+  while(network_list){
+    network_list.read(buffer, sizeof(buffer));
+    streamsize const count = network_list.gcount();
+    for(streamsize i = 0; i<count; i++){
+      hash ^= (unsigned char)buffer[i];
+      hash *= 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+bool AnyNet::loadCache(){
+  cache_hash = fileHash();
+  string const name = cacheFile();
+  int fd = open(name.c_str(), O_RDONLY);
+  if(fd < 0){
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(AnyNetCacheHeader)){
+    close(fd);
+    return false;
+  }
+  void * map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED){
+    return false;
+  }
+  AnyNetCacheHeader const * header = (AnyNetCacheHeader const *)map;
+  size_t const size = header->size;
+  size_t const nodes = header->nodes;
+  size_t const links = header->links;
+  size_t const sets = header->sets;
+  size_t const multipath_ints = use_multipath ? (size + 1 + sets + size * nodes) : 0;
+  if(memcmp(header->magic, anynet_cache_magic, sizeof(anynet_cache_magic)) ||
+     header->version != anynet_cache_version ||
+     header->hash != cache_hash ||
+     header->slack != multipath_slack ||
+     header->size < 0 || header->nodes < 0 || header->links < 0 || header->sets < 0 ||
+     (size_t)st.st_size != sizeof(AnyNetCacheHeader) + sizeof(int) * 
+     (2 * (size + 1) + 3 * links + 3 * nodes + size * nodes + multipath_ints)){
+    munmap(map, st.st_size);
+    return false;
+  }
+  cache_map = map;
+  cache_bytes = st.st_size;
+
+  int const * data = (int const *)(header + 1);
+  adj_begin.assign(data, data + size + 1); data += size + 1;
+  adj_router.assign(data, data + links); data += links;
+  adj_latency.assign(data, data + links); data += links;
+  adj_port.assign(data, data + links); data += links;
+  node_begin.assign(data, data + size + 1); data += size + 1;
+  node_id.assign(data, data + nodes); data += nodes;
+  node_latency.assign(data, data + nodes); data += nodes;
+  node_port.assign(data, data + nodes); data += nodes;
+  link_up.assign(links, 1);
+  //the routing tables are used in place
+  table = data; data += size * nodes;
+  if(use_multipath){
+    multipath_begin.assign(data, data + size + 1); data += size + 1;
+    multipath_sets.assign(data, data + sets); data += sets;
+    multipath = data;
+  }
+  cout<<"Anynet:using cached network "<<name<<endl;
+  return true;
+}
+
+static bool writeInts(FILE * file, int const * data, size_t count){
+  return fwrite(data, sizeof(int), count, file) == count;
+}
+
+void AnyNet::writeCache() const {
+  string const name = cacheFile();
+  //written under a temporary name first, so that concurrent runs never see
+  //a partial cache
+  ostringstream temp_name;
+  temp_name << name << ".tmp" << getpid();
+  FILE * file = fopen(temp_name.str().c_str(), "wb");
+  if(!file){
+    cout<<"Anynet:can't write cache file "<<name<<endl;
+    return;
+  }
+  AnyNetCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, anynet_cache_magic, sizeof(anynet_cache_magic));
+  header.version = anynet_cache_version;
+  header.hash = cache_hash;
+  header.size = _size;
+  header.nodes = _nodes;
+  header.links = _channels;
+  header.slack = multipath_slack;
+  header.sets = multipath_sets.size();
+  bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+  ok = ok && writeInts(file, &adj_begin[0], adj_begin.size());
+  ok = ok && writeInts(file, &adj_router[0], adj_router.size());
+  ok = ok && writeInts(file, &adj_latency[0], adj_latency.size());
+  ok = ok && writeInts(file, &adj_port[0], adj_port.size());
+  ok = ok && writeInts(file, &node_begin[0], node_begin.size());
+  ok = ok && writeInts(file, &node_id[0], node_id.size());
+  ok = ok && writeInts(file, &node_latency[0], node_latency.size());
+  ok = ok && writeInts(file, &node_port[0], node_port.size());
+  ok = ok && writeInts(file, table, (size_t)_size * _nodes);
+  if(use_multipath){
+    ok = ok && writeInts(file, &multipath_begin[0], multipath_begin.size());
+    ok = ok && writeInts(file, &multipath_sets[0], multipath_sets.size());
+    ok = ok && writeInts(file, multipath, (size_t)_size * _nodes);
+  }
+  ok = (fclose(file) == 0) && ok;
+  if(!ok || rename(temp_name.str().c_str(), name.c_str()) != 0){
+    remove(temp_name.str().c_str());
+    cout<<"Anynet:can't write cache file "<<name<<endl;
+  }
+}
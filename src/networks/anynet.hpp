@@ -40,17 +40,75 @@ class AnyNet : public Network {
   string file_name;
   //associtation between  nodes and routers
   map<int, int > node_list;
-  //[link type][src router][dest router]=(port, latency)
+  //[link type][src router][dest router]=(port, latency), only used while parsing
   vector<map<int,  map<int, pair<int,int> > > > router_list;
+  //router to router links in compressed sparse row form, with the output
+  //port assigned to each; links of router r are [adj_begin[r], adj_begin[r+1])
+  vector<int> adj_begin;
+  vector<int> adj_router;
+  vector<int> adj_latency;
+  vector<int> adj_port;
+  vector<char> link_up;
+  //ejection ports in the same form; nodes of router r are [node_begin[r], node_begin[r+1])
+  vector<int> node_begin;
+  vector<int> node_id;
+  vector<int> node_latency;
+  vector<int> node_port;
   //stores minimal routing information from every router to every node
-  //[router][dest_node]=port
-  vector<map<int, int> > routing_table;
+  //[router * _nodes + dest_node]=port, -1 if unreachable
+  //table points either into routing_table or into the mapped cache file
+  vector<int> routing_table;
+  int const * table;
+  int route_threads;
+
+  //candidate output ports of the multipath routing functions, only built
+  //when one of them is selected; all shortest paths, or also paths up to
+  //multipath_slack cycles longer
+  //[router * _nodes + dest_node]=offset of a port set within the router's
+  //part of multipath_sets, starting at multipath_begin[router]; a set is
+  //stored as its size followed by the ports
+  bool use_multipath;
+  int multipath_slack;
+  vector<int> multipath_table;
+  int const * multipath;
+  vector<int> multipath_begin;
+  vector<int> multipath_sets;
+  //used while building: [src router * _size + dest router]=distance, and
+  //the port sets of each router; the distances are kept, along with the
+  //link over which each router is reached ([src router * _size + router]),
+  //once links start to fail
+  vector<int> distances;
+  vector<int> tree_links;
+  vector<vector<int> > router_sets;
+  //sources to search, or to collect port sets for
+  vector<int> route_sources;
+
+  //binary cache of the link arrays and the routing table
+  bool use_cache;
+  string cache_dir;
+  unsigned long long cache_hash;
+  void * cache_map;
+  size_t cache_bytes;
 
   void _ComputeSize( const Configuration &config );
   void _BuildNet( const Configuration &config );
   void readFile();
+  void buildGraph();
+  string cacheFile() const;
+  unsigned long long fileHash() const;
+  bool loadCache();
+  void writeCache() const;
+  int linkSource(int link) const;
+  void trackFaults();
+  bool setLinkState(int r, int c, bool fault);
   void buildRoutingTable();
-  void route(int r_start);
+  static void * routeThread(void * arg);
+  void runThreads(int phase);
+  void route(int r_start, vector<int> & dist, vector<int> & hop, 
+	     vector<int> & via);
+  void buildMultipath();
+  void collectPorts(int r_start, vector<int> & ports, 
+		    map<vector<int>, int> & interned);
 
 public:
   AnyNet( const Configuration &config, const string & name );
@@ -61,9 +119,16 @@ public:
 
   static void RegisterRoutingFunctions();
   double Capacity( ) const {return -1;}
-  void InsertRandomFaults( const Configuration &config ){}
+  void InsertRandomFaults( const Configuration &config );
+  void OutChannelFault( int r, int c, bool fault = true );
 };
 
 void min_anynet( const Router *r, const Flit *f, int in_channel, 
 		      OutputSet *outputs, bool inject );
+void ecmp_random_anynet( const Router *r, const Flit *f, int in_channel, 
+			 OutputSet *outputs, bool inject );
+void ecmp_hash_anynet( const Router *r, const Flit *f, int in_channel, 
+		       OutputSet *outputs, bool inject );
+void ecmp_adaptive_anynet( const Router *r, const Flit *f, int in_channel, 
+			   OutputSet *outputs, bool inject );
 #endif
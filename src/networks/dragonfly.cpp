@@ -373,6 +373,13 @@ double DragonFlyNew::Capacity( ) const
   return (double)_k / 8.0;
 }
 
+// keep each group in one region, so that only the long global channels
+// cross between regions
+int DragonFlyNew::RouterRegion( int router, int regions ) const
+{
+  return (int)( (long long)( router / _a ) * regions / _g );
+}
+
 void DragonFlyNew::RegisterRoutingFunctions(){
 
   gRoutingFunctionMap["min_dragonflynew"] = &min_dragonflynew;
@@ -60,6 +60,7 @@ public:
   int GetK( ) const;
 
   double Capacity( ) const;
+  int RouterRegion( int router, int regions ) const;
   static void RegisterRoutingFunctions();
   void InsertRandomFaults( const Configuration &config );
 
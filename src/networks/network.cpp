@@ -32,7 +32,9 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <sstream>
 
 #include "booksim.hpp"
@@ -56,6 +58,21 @@ Network::Network( const Configuration &config, const string & name ) :
   _nodes    = -1; 
   _channels = -1;
   _classes  = config.GetInt("classes");
+  _regions  = 0;
+
+  string const backend = config.GetStr("channel_backend");
+  if ( backend == "object" ) {
+    _flat_channels = false;
+  } else if ( backend == "flat" ) {
+    _flat_channels = true;
+  } else {
+    Error( "Unknown channel backend: " + backend );
+  }
+  // the parallel engine advances the two ends of each link separately,
+  // which only the flat backend supports
+  if ( config.GetInt("parallel_regions") > 0 ) {
+    _flat_channels = true;
+  }
 }
 
 Network::~Network( )
@@ -121,9 +138,49 @@ Network * Network::New(const Configuration & config, const string & name)
   if ( n && ( config.GetInt( "link_failures" ) > 0 ) ) {
     n->InsertRandomFaults( config );
   }
+
+  if ( n ) {
+    n->_BindActivityCounters( );
+    if ( n->_flat_channels ) {
+      n->_AttachChannels( );
+    }
+  }
   return n;
 }
 
+void Network::_BindActivityCounters( )
+{
+  size_t total = 0;
+  for ( int r = 0; r < _size; ++r ) {
+    total += _routers[r]->NumActivityCounters( );
+  }
+  _activity.assign( total, 0 );
+  size_t offset = 0;
+  for ( int r = 0; r < _size; ++r ) {
+    int const size = _routers[r]->NumActivityCounters( );
+    if ( size > 0 ) {
+      _routers[r]->BindActivityCounters( &_activity[offset] );
+      offset += size;
+    }
+  }
+}
+
+void Network::_AttachChannels( )
+{
+  for ( int s = 0; s < _nodes; ++s ) {
+    _flit_links.Attach( _inject[s] );
+    _credit_links.Attach( _inject_cred[s] );
+  }
+  for ( int d = 0; d < _nodes; ++d ) {
+    _flit_links.Attach( _eject[d] );
+    _credit_links.Attach( _eject_cred[d] );
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    _flit_links.Attach( _chan[c] );
+    _credit_links.Attach( _chan_cred[c] );
+  }
+}
+
 void Network::_Alloc( )
 {
   assert( ( _size != -1 ) && 
@@ -139,18 +196,26 @@ void Network::_Alloc( )
    *shifts by one
    *credit channels are the necessary counter part
    */
+  _channel_activity.assign((2 * _nodes + _channels) * _classes, 0);
+  int * activity = _channel_activity.empty() ? NULL : &_channel_activity[0];
   _inject.resize(_nodes);
   _inject_cred.resize(_nodes);
   for ( int s = 0; s < _nodes; ++s ) {
     ostringstream name;
     name << Name() << "_fchan_ingress" << s;
     _inject[s] = new FlitChannel(this, name.str(), _classes);
+    _inject[s]->BindActivityCounters(activity);
+    activity += _classes;
     _inject[s]->SetSource(NULL, s);
-    _timed_modules.push_back(_inject[s]);
+    if ( !_flat_channels ) {
+      _timed_modules.push_back(_inject[s]);
+    }
     name.str("");
     name << Name() << "_cchan_ingress" << s;
     _inject_cred[s] = new CreditChannel(this, name.str());
-    _timed_modules.push_back(_inject_cred[s]);
+    if ( !_flat_channels ) {
+      _timed_modules.push_back(_inject_cred[s]);
+    }
   }
   _eject.resize(_nodes);
   _eject_cred.resize(_nodes);
@@ -158,12 +223,18 @@ void Network::_Alloc( )
     ostringstream name;
     name << Name() << "_fchan_egress" << d;
     _eject[d] = new FlitChannel(this, name.str(), _classes);
+    _eject[d]->BindActivityCounters(activity);
+    activity += _classes;
     _eject[d]->SetSink(NULL, d);
-    _timed_modules.push_back(_eject[d]);
+    if ( !_flat_channels ) {
+      _timed_modules.push_back(_eject[d]);
+    }
     name.str("");
     name << Name() << "_cchan_egress" << d;
     _eject_cred[d] = new CreditChannel(this, name.str());
-    _timed_modules.push_back(_eject_cred[d]);
+    if ( !_flat_channels ) {
+      _timed_modules.push_back(_eject_cred[d]);
+    }
   }
   _chan.resize(_channels);
   _chan_cred.resize(_channels);
@@ -171,39 +242,263 @@ void Network::_Alloc( )
     ostringstream name;
     name << Name() << "_fchan_" << c;
     _chan[c] = new FlitChannel(this, name.str(), _classes);
-    _timed_modules.push_back(_chan[c]);
+    _chan[c]->BindActivityCounters(activity);
+    activity += _classes;
+    if ( !_flat_channels ) {
+      _timed_modules.push_back(_chan[c]);
+    }
     name.str("");
     name << Name() << "_cchan_" << c;
     _chan_cred[c] = new CreditChannel(this, name.str());
-    _timed_modules.push_back(_chan_cred[c]);
+    if ( !_flat_channels ) {
+      _timed_modules.push_back(_chan_cred[c]);
+    }
   }
 }
 
-void Network::ReadInputs( )
+void Network::SeedRandomStreams( unsigned long long seed )
 {
+  for ( int r = 0; r < _size; ++r ) {
+    _routers[r]->SeedRandom( seed * _size + r );
+  }
+  _timed_streams.clear( );
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
+    Router const * const router = dynamic_cast<Router const *>(*iter);
+    _timed_streams.push_back( router ? router->RandomStream( ) : 0 );
+  }
+}
+
+void Network::ReadInputs( )
+{
+  if ( _flat_channels ) {
+    _flit_links.ReadInputs( );
+    _credit_links.ReadInputs( );
+  }
+  if(_timed_streams.empty()) {
+    for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+        iter != _timed_modules.end();
+        ++iter) {
+      (*iter)->ReadInputs( );
+    }
+    return;
+  }
+  assert(_timed_streams.size() == _timed_modules.size());
+  vector<unsigned long long *>::const_iterator stream = _timed_streams.begin();
+  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+      iter != _timed_modules.end();
+      ++iter, ++stream) {
+    gRandomStream = *stream;
     (*iter)->ReadInputs( );
   }
+  gRandomStream = 0;
 }
 
 void Network::Evaluate( )
 {
+  if(_timed_streams.empty()) {
+    for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+        iter != _timed_modules.end();
+        ++iter) {
+      (*iter)->Evaluate( );
+    }
+    return;
+  }
+  assert(_timed_streams.size() == _timed_modules.size());
+  vector<unsigned long long *>::const_iterator stream = _timed_streams.begin();
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
-      ++iter) {
+      ++iter, ++stream) {
+    gRandomStream = *stream;
     (*iter)->Evaluate( );
   }
+  gRandomStream = 0;
 }
 
 void Network::WriteOutputs( )
 {
+  if ( _flat_channels ) {
+    _flit_links.WriteOutputs( );
+    _credit_links.WriteOutputs( );
+  }
+  if(_timed_streams.empty()) {
+    for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+        iter != _timed_modules.end();
+        ++iter) {
+      (*iter)->WriteOutputs( );
+    }
+    return;
+  }
+  assert(_timed_streams.size() == _timed_modules.size());
+  vector<unsigned long long *>::const_iterator stream = _timed_streams.begin();
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
-      ++iter) {
+      ++iter, ++stream) {
+    gRandomStream = *stream;
     (*iter)->WriteOutputs( );
   }
+  gRandomStream = 0;
+}
+
+FlitChannel const * Network::_FlitLink( int link ) const
+{
+  if ( link < _nodes ) {
+    return _inject[link];
+  } else if ( link < 2 * _nodes ) {
+    return _eject[link - _nodes];
+  }
+  return _chan[link - 2 * _nodes];
+}
+
+CreditChannel const * Network::_CreditLink( int link ) const
+{
+  if ( link < _nodes ) {
+    return _inject_cred[link];
+  } else if ( link < 2 * _nodes ) {
+    return _eject_cred[link - _nodes];
+  }
+  return _chan_cred[link - 2 * _nodes];
+}
+
+int Network::RouterRegion( int router, int regions ) const
+{
+  return (int)( (long long)router * regions / _size );
+}
+
+void Network::Partition( int regions )
+{
+  assert( _flat_channels && ( regions > 0 ) );
+  _regions = regions;
+  _router_region.resize( _size );
+  _region_routers.assign( regions, vector<Router *>( ) );
+  for ( int r = 0; r < _size; ++r ) {
+    int const region = RouterRegion( r, regions );
+    assert( ( region >= 0 ) && ( region < regions ) );
+    _router_region[r] = region;
+    _region_routers[region].push_back( _routers[r] );
+  }
+
+  // a node's terminal belongs to the region of its injection router
+  _node_region.resize( _nodes );
+  for ( int n = 0; n < _nodes; ++n ) {
+    _node_region[n] = _router_region[_inject[n]->GetSink( )->GetID( )];
+  }
+
+  // links are numbered as attached: injection, ejection, then the
+  // channels between routers
+  int const links = 2 * _nodes + _channels;
+  _link_source.assign( links, -1 );
+  _link_sink.assign( links, -1 );
+  for ( int s = 0; s < _nodes; ++s ) {
+    _link_source[s] = _node_region[s];
+    _link_sink[s] = _node_region[s];
+  }
+  for ( int d = 0; d < _nodes; ++d ) {
+    _link_source[_nodes + d] = _router_region[_eject[d]->GetSource( )->GetID( )];
+    _link_sink[_nodes + d] = _node_region[d];
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    Router const * const source = _chan[c]->GetSource( );
+    Router const * const sink = _chan[c]->GetSink( );
+    // unconnected channels never carry anything and are left alone
+    if ( source && sink ) {
+      _link_source[2 * _nodes + c] = _router_region[source->GetID( )];
+      _link_sink[2 * _nodes + c] = _router_region[sink->GetID( )];
+    }
+  }
+
+  _region_flits_in.assign( regions, vector<int>( ) );
+  _region_flits_out.assign( regions, vector<int>( ) );
+  _region_credits_in.assign( regions, vector<int>( ) );
+  _region_credits_out.assign( regions, vector<int>( ) );
+  _region_latency.assign( regions * regions, 0 );
+  for ( int l = 0; l < links; ++l ) {
+    int const source = _link_source[l];
+    int const sink = _link_sink[l];
+    if ( source < 0 ) {
+      continue;
+    }
+    _region_flits_out[source].push_back( l );
+    _region_flits_in[sink].push_back( l );
+    _region_credits_out[sink].push_back( l );
+    _region_credits_in[source].push_back( l );
+    if ( source != sink ) {
+      int const flit_latency = _FlitLink( l )->GetLatency( );
+      int & forward = _region_latency[source * regions + sink];
+      if ( ( forward == 0 ) || ( flit_latency < forward ) ) {
+        forward = flit_latency;
+      }
+      int const credit_latency = _CreditLink( l )->GetLatency( );
+      int & backward = _region_latency[sink * regions + source];
+      if ( ( backward == 0 ) || ( credit_latency < backward ) ) {
+        backward = credit_latency;
+      }
+    }
+  }
+}
+
+int Network::RegionLatency( int from, int to ) const
+{
+  return _region_latency[from * _regions + to];
+}
+
+void Network::SizeRegionLinks( vector<int> const & lead )
+{
+  int const links = 2 * _nodes + _channels;
+  vector<int> flit_ring( links, 0 );
+  vector<int> credit_ring( links, 0 );
+  for ( int l = 0; l < links; ++l ) {
+    int const source = _link_source[l];
+    int const sink = _link_sink[l];
+    int ahead = 0, back_ahead = 0;
+    if ( ( source >= 0 ) && ( source != sink ) ) {
+      // the sender can be at most lead(receiver, sender) cycles ahead
+      ahead = lead[sink * _regions + source];
+      back_ahead = lead[source * _regions + sink];
+      if ( ( ahead == INT_MAX ) || ( back_ahead == INT_MAX ) ) {
+        Error( "Parallel regions are not connected in both directions" );
+      }
+    }
+    flit_ring[l] = _FlitLink( l )->GetLatency( ) + 2 + max( ahead, 0 );
+    credit_ring[l] = _CreditLink( l )->GetLatency( ) + 2 + max( back_ahead, 0 );
+  }
+  _flit_links.SetRings( flit_ring );
+  _credit_links.SetRings( credit_ring );
+}
+
+void Network::ReadRegionInputs( int region, int cycle )
+{
+  _flit_links.Deliver( _region_flits_in[region], cycle );
+  _credit_links.Deliver( _region_credits_in[region], cycle );
+  vector<Router *> const & routers = _region_routers[region];
+  for ( size_t i = 0; i < routers.size( ); ++i ) {
+    gRandomStream = routers[i]->RandomStream( );
+    routers[i]->ReadInputs( );
+  }
+  gRandomStream = 0;
+}
+
+void Network::EvaluateRegion( int region )
+{
+  vector<Router *> const & routers = _region_routers[region];
+  for ( size_t i = 0; i < routers.size( ); ++i ) {
+    gRandomStream = routers[i]->RandomStream( );
+    routers[i]->Evaluate( );
+  }
+  gRandomStream = 0;
+}
+
+void Network::WriteRegionOutputs( int region, int cycle )
+{
+  vector<Router *> const & routers = _region_routers[region];
+  for ( size_t i = 0; i < routers.size( ); ++i ) {
+    gRandomStream = routers[i]->RandomStream( );
+    routers[i]->WriteOutputs( );
+  }
+  gRandomStream = 0;
+  _flit_links.Commit( _region_flits_out[region], cycle );
+  _credit_links.Commit( _region_credits_out[region], cycle );
 }
 
 void Network::WriteFlit( Flit *f, int source )
@@ -39,6 +39,7 @@
 #include "timed_module.hpp"
 #include "flitchannel.hpp"
 #include "channel.hpp"
+#include "channel_array.hpp"
 #include "config_utils.hpp"
 #include "globals.hpp"
 
@@ -65,11 +66,48 @@ protected:
   vector<CreditChannel *> _chan_cred;
 
   deque<TimedModule *> _timed_modules;
+  // random stream of each timed module, NULL for the channels; empty
+  // while the routers share the global generator
+  vector<unsigned long long *> _timed_streams;
+
+  // buffer and switch activity counters of all routers, in one block
+  vector<int> _activity;
+
+  // per-class flit counters of all flit channels, in one block
+  vector<int> _channel_activity;
+
+  // with the flat channel backend, the delay lines of all channels live
+  // here and are advanced in bulk instead of as timed modules
+  bool _flat_channels;
+  ChannelArray<Flit> _flit_links;
+  ChannelArray<Credit> _credit_links;
+
+  // regions of the parallel engine
+  int _regions;
+  vector<int> _router_region;
+  vector<int> _node_region;
+  vector<vector<Router *> > _region_routers;
+  vector<vector<int> > _region_flits_in;
+  vector<vector<int> > _region_flits_out;
+  vector<vector<int> > _region_credits_in;
+  vector<vector<int> > _region_credits_out;
+  // lowest latency of the channels from one region to another, 0 if none
+  vector<int> _region_latency;
+  // sending and receiving region of the flits on each link; credits go
+  // the other way
+  vector<int> _link_source;
+  vector<int> _link_sink;
 
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
   void _Alloc( );
+  void _BindActivityCounters( );
+  void _AttachChannels( );
+
+  // channels of a flat backend link number
+  FlitChannel const * _FlitLink( int link ) const;
+  CreditChannel const * _CreditLink( int link ) const;
 
 public:
   Network( const Configuration &config, const string & name );
@@ -86,14 +124,36 @@ public:
   inline int NumNodes( ) const {return _nodes;}
 
   virtual void InsertRandomFaults( const Configuration &config );
-  void OutChannelFault( int r, int c, bool fault = true );
+  virtual void OutChannelFault( int r, int c, bool fault = true );
 
   virtual double Capacity( ) const;
 
+  // Give every router a random stream of its own, derived from seed and
+  // the router id, so that router draws do not depend on the order or
+  // the thread in which routers are evaluated.  Without this call the
+  // routers draw from the global generator.
+  void SeedRandomStreams( unsigned long long seed );
+
   virtual void ReadInputs( );
   virtual void Evaluate( );
   virtual void WriteOutputs( );
 
+  // Split the routers into regions for the parallel engine, which then
+  // advances each region with the Region calls below instead of the
+  // ones above.
+  void Partition( int regions );
+  virtual int RouterRegion( int router, int regions ) const;
+  inline int GetRouterRegion( int router ) const {return _router_region[router];}
+  inline int GetNodeRegion( int node ) const {return _node_region[node];}
+  int RegionLatency( int from, int to ) const;
+  // lead[from * regions + to] bounds how many cycles region `to`
+  // can run ahead of region `from`; used to size the delay lines
+  void SizeRegionLinks( vector<int> const & lead );
+
+  void ReadRegionInputs( int region, int cycle );
+  void EvaluateRegion( int region );
+  void WriteRegionOutputs( int region, int cycle );
+
   void Display( ostream & os = cout ) const;
   void DumpChannelMap( ostream & os = cout, string const & prefix = "" ) const;
   void DumpNodeMap( ostream & os = cout, string const & prefix = "" ) const;
@@ -112,6 +172,8 @@ public:
   const vector<Router *> & GetRouters(){return _routers;}
   Router * GetRouter(int index) {return _routers[index];}
   int NumRouters() const {return _size;}
+
+  const vector<int> & GetActivityCounters() const {return _activity;}
 };
 
 #endif 
@@ -25,27 +25,38 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cassert>
+#include <pthread.h>
+
 #include "packet_reply_info.hpp"
 
 stack<PacketReplyInfo*> PacketReplyInfo::_all;
 stack<PacketReplyInfo*> PacketReplyInfo::_free;
+vector<stack<PacketReplyInfo*> *> PacketReplyInfo::_thread_free;
+__thread stack<PacketReplyInfo*> * PacketReplyInfo::_local_free = NULL;
+
+// guards _all and _thread_free once worker threads allocate replies
+static pthread_mutex_t reply_lock = PTHREAD_MUTEX_INITIALIZER;
 
 PacketReplyInfo * PacketReplyInfo::New()
 {
+  stack<PacketReplyInfo*> & free = _local_free ? *_local_free : _free;
   PacketReplyInfo * pr;
-  if(_free.empty()) {
+  if(free.empty()) {
     pr = new PacketReplyInfo();
+    pthread_mutex_lock(&reply_lock);
     _all.push(pr);
+    pthread_mutex_unlock(&reply_lock);
   } else {
-    pr = _free.top();
-    _free.pop();
+    pr = free.top();
+    free.pop();
   }
   return pr;
 }
 
 void PacketReplyInfo::Free()
 {
-  _free.push(this);
+  (_local_free ? _local_free : &_free)->push(this);
 }
 
 void PacketReplyInfo::FreeAll()
@@ -54,4 +65,17 @@ void PacketReplyInfo::FreeAll()
     delete _all.top();
     _all.pop();
   }
+  for(size_t i = 0; i < _thread_free.size(); ++i) {
+    delete _thread_free[i];
+  }
+  _thread_free.clear();
+}
+
+void PacketReplyInfo::AttachThread()
+{
+  assert(!_local_free);
+  _local_free = new stack<PacketReplyInfo*>;
+  pthread_mutex_lock(&reply_lock);
+  _thread_free.push_back(_local_free);
+  pthread_mutex_unlock(&reply_lock);
 }
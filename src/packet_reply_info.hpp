@@ -29,6 +29,7 @@
 #define _PACKET_REPLY_INFO_HPP_
 
 #include <stack>
+#include <vector>
 
 #include "flit.hpp"
 
@@ -37,6 +38,7 @@ class PacketReplyInfo {
 
 public:
   int source;
+  int pid;
   int time;
   bool record;
   Flit::FlitType type;
@@ -45,10 +47,16 @@ public:
   void Free();
   static void FreeAll();
 
+  // Give the calling thread a free list of its own; used by the threads
+  // of the parallel engine, where a node queues and issues its replies.
+  static void AttachThread();
+
 private:
 
   static stack<PacketReplyInfo*> _all;
   static stack<PacketReplyInfo*> _free;
+  static vector<stack<PacketReplyInfo*> *> _thread_free;
+  static __thread stack<PacketReplyInfo*> * _local_free;
 
   PacketReplyInfo() {}
   ~PacketReplyInfo() {}
@@ -0,0 +1,409 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "packet_trace.hpp"
+
+// number of records per chunk and number of chunks decoded ahead of use
+static size_t const CHUNK_RECORDS = 16384;
+static size_t const MAX_CHUNKS = 4;
+
+char const TraceReader::MAGIC[8] = { 'B', 'S', 'T', 'R', 'A', 'C', 'E', '\0' };
+
+template<typename T>
+static inline T _Load( char const * p )
+{
+  T v;
+  memcpy(&v, p, sizeof(T));
+  return v;
+}
+
+TraceReader::TraceReader( string const & filename, int passes )
+  : _filename(filename), _fd(-1), _base(NULL), _length(0), _records(0), 
+    _nodes(0), _passes(passes), _flags(0), _offset(HEADER_SIZE), _read(0), 
+    _pass(0), _pass_time(0), _last_time(-1), _file_time(0), _released(0), 
+    _done(false), _stop(false), _pos(0)
+{
+  _fd = open(filename.c_str(), O_RDONLY);
+  if(_fd < 0) {
+    cout << "Error: Unable to open trace file: " << filename << endl;
+    exit(-1);
+  }
+  struct stat st;
+  if((fstat(_fd, &st) < 0) || (st.st_size < HEADER_SIZE)) {
+    cout << "Error: Trace file is truncated: " << filename << endl;
+    exit(-1);
+  }
+  _length = st.st_size;
+  void * const base = mmap(NULL, _length, PROT_READ, MAP_PRIVATE, _fd, 0);
+  if(base == MAP_FAILED) {
+    cout << "Error: Unable to map trace file: " << filename << endl;
+    exit(-1);
+  }
+  _base = (char const *)base;
+  madvise(base, _length, MADV_SEQUENTIAL);
+
+  if(memcmp(_base, MAGIC, sizeof(MAGIC)) || 
+     (_Load<uint32_t>(_base + 8) != (uint32_t)VERSION)) {
+    cout << "Error: Not a version " << VERSION << " trace file: " << filename << endl;
+    exit(-1);
+  }
+  _flags = _Load<uint32_t>(_base + 12);
+  if(_flags & ~DELTA_ENCODED) {
+    cout << "Error: Unsupported trace encoding in " << filename << endl;
+    exit(-1);
+  }
+  _records = (long long)_Load<uint64_t>(_base + 16);
+  _nodes = (int)_Load<uint32_t>(_base + 24);
+  if(!(_flags & DELTA_ENCODED) && 
+     (_length != HEADER_SIZE + (size_t)_records * RECORD_SIZE)) {
+    cout << "Error: Trace file size does not match record count: " << filename << endl;
+    exit(-1);
+  }
+
+  pthread_mutex_init(&_lock, NULL);
+  pthread_cond_init(&_not_empty, NULL);
+  pthread_cond_init(&_not_full, NULL);
+  if(pthread_create(&_thread, NULL, &TraceReader::_ReadAhead, this)) {
+    cout << "Error: Unable to start trace read-ahead thread." << endl;
+    exit(-1);
+  }
+}
+
+TraceReader::~TraceReader( )
+{
+  pthread_mutex_lock(&_lock);
+  _stop = true;
+  pthread_cond_signal(&_not_full);
+  pthread_mutex_unlock(&_lock);
+  pthread_join(_thread, NULL);
+  pthread_cond_destroy(&_not_full);
+  pthread_cond_destroy(&_not_empty);
+  pthread_mutex_destroy(&_lock);
+  munmap((void *)_base, _length);
+  close(_fd);
+}
+
+void * TraceReader::_ReadAhead( void * reader )
+{
+  ((TraceReader *)reader)->_Produce();
+  return NULL;
+}
+
+// Decode the next record into r, wrapping around to the start of the file 
+// for repeated passes; returns false once all passes are complete.
+bool TraceReader::_Decode( TraceRecord & r )
+{
+  if(_read >= _records) {
+    if((_records == 0) || ((_passes > 0) && (_pass + 1 >= _passes))) {
+      return false;
+    }
+    ++_pass;
+    _pass_time = _last_time + 1;
+    _file_time = 0;
+    _read = 0;
+    _offset = HEADER_SIZE;
+    _released = 0;
+  }
+  long long const base_index = (long long)_pass * _records;
+  r.index = base_index + _read;
+  long long dep;
+  if(_flags & DELTA_ENCODED) {
+    _file_time += (long long)_Varint();
+    r.time = _pass_time + _file_time;
+    r.src = (int)_Varint();
+    r.dest = (int)_Varint();
+    r.size = (int)_Varint();
+    r.cl = (int)_Varint();
+    r.type = (int)_Varint();
+    long long const dist = (long long)_Varint();
+    dep = (dist == 0) ? -1 : (_read - dist);
+  } else {
+    char const * const p = _base + _offset;
+    r.time = _pass_time + _Load<int64_t>(p);
+    dep = _Load<int64_t>(p + 8);
+    r.src = _Load<int32_t>(p + 16);
+    r.dest = _Load<int32_t>(p + 20);
+    r.size = _Load<int32_t>(p + 24);
+    r.cl = _Load<int16_t>(p + 28);
+    r.type = _Load<int16_t>(p + 30);
+    _offset += RECORD_SIZE;
+  }
+  r.dep = (dep < 0) ? -1 : (base_index + dep);
+  if((dep >= _read) || (dep < -1) || (r.time < _last_time)) {
+    cout << "Error: Trace file " << _filename << " is not ordered at record " 
+	 << _read << "." << endl;
+    exit(-1);
+  }
+  _last_time = r.time;
+  ++_read;
+  return true;
+}
+
+unsigned long long TraceReader::_Varint( )
+{
+  unsigned long long v = 0;
+  int shift = 0;
+  while(true) {
+    if((_offset >= _length) || (shift > 63)) {
+      cout << "Error: Trace file " << _filename << " is truncated at record " 
+	   << _read << "." << endl;
+      exit(-1);
+    }
+    unsigned char const b = (unsigned char)_base[_offset++];
+    v |= (unsigned long long)(b & 0x7f) << shift;
+    if(!(b & 0x80)) {
+      break;
+    }
+    shift += 7;
+  }
+  return v;
+}
+
+void TraceReader::_Produce( )
+{
+  long const page = sysconf(_SC_PAGESIZE);
+  vector<TraceRecord> chunk;
+  while(true) {
+    pthread_mutex_lock(&_lock);
+    while(!_stop && (_ready.size() >= MAX_CHUNKS)) {
+      pthread_cond_wait(&_not_full, &_lock);
+    }
+    bool const stop = _stop;
+    pthread_mutex_unlock(&_lock);
+    if(stop) {
+      break;
+    }
+
+    chunk.resize(CHUNK_RECORDS);
+    size_t n = 0;
+    while((n < CHUNK_RECORDS) && _Decode(chunk[n])) {
+      ++n;
+    }
+    chunk.resize(n);
+
+    // drop pages that have already been decoded so that resident memory 
+    // stays bounded for traces larger than main memory
+    size_t const release = (_offset / page) * page;
+    if(release > _released) {
+      madvise((void *)(_base + _released), release - _released, MADV_DONTNEED);
+      _released = release;
+    }
+
+    pthread_mutex_lock(&_lock);
+    if(n > 0) {
+      _ready.push_back(vector<TraceRecord>());
+      _ready.back().swap(chunk);
+    }
+    if(n < CHUNK_RECORDS) {
+      _done = true;
+    }
+    pthread_cond_signal(&_not_empty);
+    pthread_mutex_unlock(&_lock);
+    if(n < CHUNK_RECORDS) {
+      break;
+    }
+  }
+}
+
+bool TraceReader::_Refill( )
+{
+  pthread_mutex_lock(&_lock);
+  while(_ready.empty() && !_done) {
+    pthread_cond_wait(&_not_empty, &_lock);
+  }
+  bool const available = !_ready.empty();
+  if(available) {
+    _chunk.swap(_ready.front());
+    _ready.pop_front();
+    _pos = 0;
+    pthread_cond_signal(&_not_full);
+  }
+  pthread_mutex_unlock(&_lock);
+  return available;
+}
+
+TraceWriter::TraceWriter( string const & filename, int nodes )
+  : _filename(filename), _file(NULL), _nodes(nodes), _records(0), 
+    _time_offset(0), _last_time(0), _stop(false), _file_time(0)
+{
+  _file = fopen(filename.c_str(), "wb");
+  if(!_file) {
+    cout << "Error: Unable to open trace capture file: " << filename << endl;
+    exit(-1);
+  }
+  // the record count is filled in once the capture is complete
+  char header[TraceReader::HEADER_SIZE];
+  memset(header, 0, sizeof(header));
+  memcpy(header, TraceReader::MAGIC, sizeof(TraceReader::MAGIC));
+  uint32_t const version = TraceReader::VERSION;
+  uint32_t const flags = TraceReader::DELTA_ENCODED;
+  uint32_t const n = nodes;
+  memcpy(header + 8, &version, sizeof(version));
+  memcpy(header + 12, &flags, sizeof(flags));
+  memcpy(header + 24, &n, sizeof(n));
+  fwrite(header, 1, sizeof(header), _file);
+
+  _batch.reserve(CHUNK_RECORDS);
+  pthread_mutex_init(&_lock, NULL);
+  pthread_cond_init(&_not_empty, NULL);
+  pthread_cond_init(&_not_full, NULL);
+  if(pthread_create(&_thread, NULL, &TraceWriter::_WriteBehind, this)) {
+    cout << "Error: Unable to start trace writer thread." << endl;
+    exit(-1);
+  }
+}
+
+TraceWriter::~TraceWriter( )
+{
+  pthread_mutex_lock(&_lock);
+  if(!_batch.empty()) {
+    _pending.push_back(vector<TraceRecord>());
+    _pending.back().swap(_batch);
+  }
+  _stop = true;
+  pthread_cond_signal(&_not_empty);
+  pthread_mutex_unlock(&_lock);
+  pthread_join(_thread, NULL);
+  pthread_cond_destroy(&_not_full);
+  pthread_cond_destroy(&_not_empty);
+  pthread_mutex_destroy(&_lock);
+
+  uint64_t const records = _records;
+  fseek(_file, 16, SEEK_SET);
+  fwrite(&records, sizeof(records), 1, _file);
+  if(fclose(_file)) {
+    cout << "Error: Unable to write trace capture file: " << _filename << endl;
+    exit(-1);
+  }
+}
+
+void TraceWriter::Write( int time, int src, int dest, int size, int cl, 
+			 int type, long long dep )
+{
+  long long t = _time_offset + time;
+  if(t < _last_time) {
+    _time_offset = _last_time - time;
+    t = _last_time;
+  }
+  _last_time = t;
+
+  TraceRecord r;
+  r.index = _records++;
+  r.time = t;
+  r.dep = dep;
+  r.src = src;
+  r.dest = dest;
+  r.size = size;
+  r.cl = cl;
+  r.type = type;
+  _batch.push_back(r);
+
+  if(_batch.size() >= CHUNK_RECORDS) {
+    pthread_mutex_lock(&_lock);
+    while(_pending.size() >= MAX_CHUNKS) {
+      pthread_cond_wait(&_not_full, &_lock);
+    }
+    _pending.push_back(vector<TraceRecord>());
+    _pending.back().swap(_batch);
+    pthread_cond_signal(&_not_empty);
+    pthread_mutex_unlock(&_lock);
+    _batch.reserve(CHUNK_RECORDS);
+  }
+}
+
+void * TraceWriter::_WriteBehind( void * writer )
+{
+  ((TraceWriter *)writer)->_Consume();
+  return NULL;
+}
+
+void TraceWriter::_Consume( )
+{
+  vector<TraceRecord> batch;
+  while(true) {
+    pthread_mutex_lock(&_lock);
+    while(!_stop && _pending.empty()) {
+      pthread_cond_wait(&_not_empty, &_lock);
+    }
+    bool const done = _pending.empty();
+    if(!done) {
+      batch.swap(_pending.front());
+      _pending.pop_front();
+      pthread_cond_signal(&_not_full);
+    }
+    pthread_mutex_unlock(&_lock);
+    if(done) {
+      break;
+    }
+    for(size_t i = 0; i < batch.size(); ++i) {
+      _Encode(batch[i]);
+    }
+    _Flush();
+    batch.clear();
+  }
+}
+
+static inline void _PutVarint( vector<unsigned char> & buffer, 
+			       unsigned long long v )
+{
+  while(v >= 0x80) {
+    buffer.push_back((unsigned char)(v | 0x80));
+    v >>= 7;
+  }
+  buffer.push_back((unsigned char)v);
+}
+
+void TraceWriter::_Encode( TraceRecord const & r )
+{
+  _PutVarint(_buffer, r.time - _file_time);
+  _file_time = r.time;
+  _PutVarint(_buffer, r.src);
+  _PutVarint(_buffer, r.dest);
+  _PutVarint(_buffer, r.size);
+  _PutVarint(_buffer, r.cl);
+  _PutVarint(_buffer, r.type);
+  _PutVarint(_buffer, (r.dep < 0) ? 0 : (r.index - r.dep));
+}
+
+void TraceWriter::_Flush( )
+{
+  if(!_buffer.empty() && 
+     (fwrite(&_buffer[0], 1, _buffer.size(), _file) != _buffer.size())) {
+    cout << "Error: Unable to write trace capture file: " << _filename << endl;
+    exit(-1);
+  }
+  _buffer.clear();
+}
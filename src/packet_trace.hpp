@@ -0,0 +1,195 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*packet_trace.hpp
+ *
+ *Binary packet trace format, a memory-mapped reader that decodes the
+ *trace on a background thread, so that traces much larger than main memory
+ *can be replayed, and a writer that encodes captured packets on a 
+ *background thread.
+ *
+ *A trace file starts with a 32-byte header
+ *
+ *  char     magic[8]   "BSTRACE"
+ *  uint32_t version    1
+ *  uint32_t flags      0 or DELTA_ENCODED
+ *  uint64_t records    number of records in the file
+ *  uint32_t nodes      number of nodes the trace was generated for (0 = any)
+ *  uint32_t reserved
+ *
+ *followed by fixed-size 32-byte records sorted by time
+ *
+ *  int64_t  time       injection cycle
+ *  int64_t  dep        index of a record whose packet must have been 
+ *                      received before this one is injected (-1 = none)
+ *  int32_t  src, dest, size (in flits)
+ *  int16_t  cl, type   traffic class and Flit::FlitType
+ *
+ *All fields are stored in little-endian byte order.
+ *
+ *With DELTA_ENCODED set, each record is instead a sequence of unsigned 
+ *LEB128 varints
+ *
+ *  time - time of previous record, src, dest, size, cl, type,
+ *  index - dep (0 = none)
+ *
+ *which takes 7 to 10 bytes for typical captures.
+ */
+
+#ifndef _PACKET_TRACE_HPP_
+#define _PACKET_TRACE_HPP_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <pthread.h>
+
+using namespace std;
+
+struct TraceRecord {
+  long long index;
+  long long time;
+  long long dep;
+  int src;
+  int dest;
+  int size;
+  int cl;
+  int type;
+};
+
+class TraceReader {
+
+  string _filename;
+  int _fd;
+  char const * _base;
+  size_t _length;
+
+  long long _records;
+  int _nodes;
+  int _passes;
+  unsigned int _flags;
+
+  // producer state, only touched by the read-ahead thread
+  size_t _offset;
+  long long _read;
+  int _pass;
+  long long _pass_time;
+  long long _last_time;
+  long long _file_time;
+  size_t _released;
+
+  // chunks handed from the read-ahead thread to the simulator
+  pthread_t _thread;
+  pthread_mutex_t _lock;
+  pthread_cond_t _not_empty;
+  pthread_cond_t _not_full;
+  deque<vector<TraceRecord> > _ready;
+  bool _done;
+  bool _stop;
+
+  // consumer state
+  vector<TraceRecord> _chunk;
+  size_t _pos;
+
+  static void * _ReadAhead( void * reader );
+  void _Produce( );
+  bool _Decode( TraceRecord & r );
+  unsigned long long _Varint( );
+  bool _Refill( );
+
+public:
+
+  static char const MAGIC[8];
+  static int const VERSION = 1;
+  static int const HEADER_SIZE = 32;
+  static int const RECORD_SIZE = 32;
+  static unsigned int const DELTA_ENCODED = 1;
+
+  TraceReader( string const & filename, int passes = 1 );
+  ~TraceReader( );
+
+  inline long long NumRecords( ) const { return _records; }
+  inline int NumNodes( ) const { return _nodes; }
+
+  // Returns the next record, or NULL once the trace is exhausted; blocks 
+  // while the read-ahead thread is catching up.
+  inline TraceRecord const * Front( ) {
+    if((_pos >= _chunk.size()) && !_Refill()) {
+      return NULL;
+    }
+    return &_chunk[_pos];
+  }
+  inline void Pop( ) { ++_pos; }
+
+};
+
+class TraceWriter {
+
+  string _filename;
+  FILE * _file;
+  int _nodes;
+
+  // simulator state
+  vector<TraceRecord> _batch;
+  long long _records;
+  long long _time_offset;
+  long long _last_time;
+
+  // batches handed from the simulator to the writer thread
+  pthread_t _thread;
+  pthread_mutex_t _lock;
+  pthread_cond_t _not_empty;
+  pthread_cond_t _not_full;
+  deque<vector<TraceRecord> > _pending;
+  bool _stop;
+
+  // writer state, only touched by the writer thread
+  long long _file_time;
+  vector<unsigned char> _buffer;
+
+  static void * _WriteBehind( void * writer );
+  void _Consume( );
+  void _Encode( TraceRecord const & r );
+  void _Flush( );
+
+public:
+
+  TraceWriter( string const & filename, int nodes );
+  ~TraceWriter( );
+
+  // Appends a packet; dep is the index of an earlier record (or -1).  Time 
+  // may restart from zero between simulations, in which case the capture 
+  // continues from the last recorded time.
+  void Write( int time, int src, int dest, int size, int cl, int type, 
+	      long long dep = -1 );
+
+  inline long long NumRecords( ) const { return _records; }
+
+};
+
+#endif
@@ -0,0 +1,141 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+#include "pair_stats.hpp"
+
+PairStats::PairStats( int nodes, bool sparse, bool tails )
+  : _nodes(nodes), _sparse(sparse), _tails(tails)
+{
+  Clear();
+}
+
+void PairStats::Clear( )
+{
+  size_t const slots = _sparse ? 0 : ((size_t)_nodes * (size_t)_nodes);
+  _slot.clear();
+  _num_samples.assign(slots, 0);
+  _sample_sum.assign(slots, 0.0);
+  _max.assign(slots, -numeric_limits<float>::quiet_NaN());
+  _tail_hist.assign(_tails ? (slots * TAIL_BUCKETS) : 0, 0);
+}
+
+long long PairStats::_Find( int src, int dest ) const
+{
+  assert((src >= 0) && (src < _nodes) && (dest >= 0) && (dest < _nodes));
+  long long const pair = (long long)src * _nodes + dest;
+  if(!_sparse) {
+    return pair;
+  }
+  map<long long, long long>::const_iterator iter = _slot.find(pair);
+  return (iter == _slot.end()) ? -1 : iter->second;
+}
+
+int PairStats::_TailBucket( double val )
+{
+  if(!(val >= 4.0)) {
+    return (val >= 0.0) ? (int)val : 0;
+  }
+  // val lies in [2^e, 2^(e+1)); split that range in two
+  int e;
+  double const m = frexp(val, &e);
+  int const b = 2 * e - 2 + ((m >= 0.75) ? 1 : 0);
+  return (b < TAIL_BUCKETS) ? b : (TAIL_BUCKETS - 1);
+}
+
+double PairStats::_TailBucketMax( int b )
+{
+  if(b < 4) {
+    return (double)b;
+  }
+  // bucket b covers [(2 + b % 2) * 2^(b / 2 - 1), (3 + b % 2) * 2^(b / 2 - 1))
+  return ldexp((double)(3 + b % 2), b / 2 - 1) - 1.0;
+}
+
+void PairStats::AddSample( int src, int dest, double val )
+{
+  long long slot = _Find(src, dest);
+  if(slot < 0) {
+    slot = _num_samples.size();
+    _slot.insert(make_pair((long long)src * _nodes + dest, slot));
+    _num_samples.push_back(0);
+    _sample_sum.push_back(0.0);
+    _max.push_back(-numeric_limits<float>::quiet_NaN());
+    if(_tails) {
+      _tail_hist.resize(_tail_hist.size() + TAIL_BUCKETS, 0);
+    }
+  }
+  ++_num_samples[slot];
+  _sample_sum[slot] += val;
+
+  // NOTE: the negation ensures that NaN values are handled correctly!
+  float const v = (float)val;
+  _max[slot] = !(v <= _max[slot]) ? v : _max[slot];
+
+  if(_tails) {
+    ++_tail_hist[slot * TAIL_BUCKETS + _TailBucket(val)];
+  }
+}
+
+int PairStats::NumSamples( int src, int dest ) const
+{
+  long long const slot = _Find(src, dest);
+  return (slot < 0) ? 0 : _num_samples[slot];
+}
+
+double PairStats::Average( int src, int dest ) const
+{
+  long long const slot = _Find(src, dest);
+  double sum = 0.0;
+  int n = 0;
+  if(slot >= 0) {
+    sum = _sample_sum[slot];
+    n = _num_samples[slot];
+  }
+  return sum / (double)n;
+}
+
+double PairStats::Quantile( int src, int dest, double q ) const
+{
+  assert(_tails);
+  long long const slot = _Find(src, dest);
+  if((slot < 0) || (_num_samples[slot] == 0)) {
+    return numeric_limits<double>::quiet_NaN();
+  }
+  double const rank = fmax(ceil(q * (double)_num_samples[slot]), 1.0);
+  double count = 0.0;
+  for(int b = 0; b < TAIL_BUCKETS; ++b) {
+    count += (double)_tail_hist[slot * TAIL_BUCKETS + b];
+    if(count >= rank) {
+      return fmin(_TailBucketMax(b), (double)_max[slot]);
+    }
+  }
+  return (double)_max[slot];
+}
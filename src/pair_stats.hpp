@@ -0,0 +1,91 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*pair_stats.hpp
+ *
+ *Per (source, destination) pair sample statistics kept in flat arrays
+ *instead of one Stats object per pair.  In sparse mode, storage is only
+ *allocated for pairs that have received at least one sample.
+ */
+
+#ifndef _PAIR_STATS_HPP_
+#define _PAIR_STATS_HPP_
+
+#include <vector>
+#include <map>
+
+using namespace std;
+
+class PairStats {
+
+  // coarse per-pair latency histogram: values below 4 are counted 
+  // exactly, larger ones in two buckets per power of two, i.e., within 
+  // a factor of 1.5 of the value; the last bucket collects all values 
+  // from 3 * 2^18 on
+  static int const TAIL_BUCKETS = 40;
+
+  int _nodes;
+  bool _sparse;
+  bool _tails;
+
+  // slot of each pair in the arrays below (sparse mode only; in dense mode 
+  // the slot is the pair index src * _nodes + dest)
+  map<long long, long long> _slot;
+
+  vector<int> _num_samples;
+  vector<double> _sample_sum;
+  // latencies are integers, so single precision is exact for the maximum
+  vector<float> _max;
+  // TAIL_BUCKETS counters per slot, if _tails is set
+  vector<int> _tail_hist;
+
+  long long _Find( int src, int dest ) const;
+
+  static int _TailBucket( double val );
+  static double _TailBucketMax( int b );
+
+public:
+
+  // tails: also keep the histogram that Quantile needs
+  PairStats( int nodes, bool sparse = false, bool tails = false );
+
+  void Clear( );
+
+  void AddSample( int src, int dest, double val );
+
+  int    NumSamples( int src, int dest ) const;
+  double Average( int src, int dest ) const;
+  // upper bound of the histogram bucket holding the q-quantile, clamped 
+  // to the largest sample
+  double Quantile( int src, int dest, double q ) const;
+
+  // number of pairs with storage allocated
+  long long NumPairs( ) const { return _num_samples.size(); }
+
+};
+
+#endif
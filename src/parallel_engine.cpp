@@ -0,0 +1,228 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+#include <sched.h>
+
+#include "booksim.hpp"
+#include "parallel_engine.hpp"
+#include "trafficmanager.hpp"
+#include "credit.hpp"
+#include "flit.hpp"
+#include "packet_reply_info.hpp"
+
+ParallelEngine::ParallelEngine( Configuration const & config, 
+				vector<Network *> const & net, 
+				TrafficManager * tm )
+  : _net(net), _tm(tm), _base(0), _stop(false)
+{
+  _regions = config.GetInt("parallel_regions");
+  assert(_regions > 0);
+  if(_regions > _net[0]->NumRouters()) {
+    _regions = _net[0]->NumRouters();
+  }
+
+  for(size_t s = 0; s < _net.size(); ++s) {
+    _net[s]->Partition(_regions);
+  }
+
+  // wait-for graph: weight[q * _regions + r] is the lookahead of r on q
+  vector<int> weight(_regions * _regions, INT_MAX);
+  int lookahead = INT_MAX;
+  for(int from = 0; from < _regions; ++from) {
+    for(int to = 0; to < _regions; ++to) {
+      if(from == to) {
+	continue;
+      }
+      int latency = 0;
+      for(size_t s = 0; s < _net.size(); ++s) {
+	int const l = _net[s]->RegionLatency(from, to);
+	if((l > 0) && ((latency == 0) || (l < latency))) {
+	  latency = l;
+	}
+      }
+      if(latency > 0) {
+	weight[from * _regions + to] = latency;
+	lookahead = min(lookahead, latency);
+      }
+    }
+  }
+  _inputs.resize(_regions);
+  for(int from = 0; from < _regions; ++from) {
+    for(int to = 0; to < _regions; ++to) {
+      if(weight[from * _regions + to] != INT_MAX) {
+	_inputs[to].push_back(make_pair(from, weight[from * _regions + to]));
+      }
+    }
+  }
+  // regions never run a cycle the traffic manager has not released
+  for(int r = 0; r < _regions; ++r) {
+    _inputs[r].push_back(make_pair(_regions, -1));
+  }
+
+  // lead[q * _regions + r]: how many cycles r can run ahead of q.  A wait
+  // bounds the cycle r runs by clock(q) + lookahead, but q may itself be
+  // running the next cycle already, so each step along a chain of waits
+  // adds its lookahead plus one, less one for the last.
+  vector<int> lead(_regions * _regions, INT_MAX);
+  for(int i = 0; i < _regions * _regions; ++i) {
+    if(weight[i] != INT_MAX) {
+      lead[i] = weight[i] + 1;
+    }
+  }
+  for(int i = 0; i < _regions; ++i) {
+    lead[i * _regions + i] = 0;
+  }
+  for(int k = 0; k < _regions; ++k) {
+    for(int i = 0; i < _regions; ++i) {
+      if(lead[i * _regions + k] == INT_MAX) {
+	continue;
+      }
+      for(int j = 0; j < _regions; ++j) {
+	if(lead[k * _regions + j] == INT_MAX) {
+	  continue;
+	}
+	int const d = lead[i * _regions + k] + lead[k * _regions + j];
+	if(d < lead[i * _regions + j]) {
+	  lead[i * _regions + j] = d;
+	}
+      }
+    }
+  }
+  for(int i = 0; i < _regions * _regions; ++i) {
+    if(lead[i] != INT_MAX) {
+      --lead[i];
+    }
+  }
+  for(size_t s = 0; s < _net.size(); ++s) {
+    _net[s]->SizeRegionLinks(lead);
+  }
+
+  cout << "Parallel engine: " << _regions << " regions, lookahead ";
+  if(lookahead == INT_MAX) {
+    cout << "-";
+  } else {
+    cout << lookahead;
+  }
+  cout << " cycles between regions" << endl;
+
+  _clock.assign((_regions + 1) * CLOCK_STRIDE, 0);
+  _args.resize(_regions);
+  _threads.resize(_regions);
+  for(int r = 0; r < _regions; ++r) {
+    _args[r] = make_pair(this, r);
+    if(pthread_create(&_threads[r], NULL, &ParallelEngine::_Run, &_args[r])) {
+      cout << "Error: Unable to start thread for region " << r << endl;
+      exit(-1);
+    }
+  }
+}
+
+ParallelEngine::~ParallelEngine( )
+{
+  Sync();
+  __atomic_store_n(&_stop, true, __ATOMIC_RELEASE);
+  for(int r = 0; r < _regions; ++r) {
+    pthread_join(_threads[r], NULL);
+  }
+}
+
+void * ParallelEngine::_Run( void * args )
+{
+  pair<ParallelEngine *, int> const * const a = 
+    (pair<ParallelEngine *, int> const *)args;
+  a->first->_Region(a->second);
+  return NULL;
+}
+
+bool ParallelEngine::_Wait( int lp, int cycle )
+{
+  int spins = 0;
+  while(_Clock(lp) < cycle) {
+    if(__atomic_load_n(&_stop, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    if(++spins >= 64) {
+      sched_yield();
+    }
+  }
+  return true;
+}
+
+void ParallelEngine::_Region( int region )
+{
+  int time = 0;
+  gThreadTime = &time;
+  Credit::AttachThread();
+  Flit::AttachThread();
+  PacketReplyInfo::AttachThread();
+
+  vector<pair<int, int> > const & inputs = _inputs[region];
+  for(int cycle = 0; ; ++cycle) {
+    for(size_t i = 0; i < inputs.size(); ++i) {
+      if(!_Wait(inputs[i].first, cycle - inputs[i].second)) {
+	return;
+      }
+    }
+    time = cycle - _base;
+
+    for(size_t s = 0; s < _net.size(); ++s) {
+      _net[s]->ReadRegionInputs(region, cycle);
+    }
+    _tm->_StepRegion(region, time);
+    for(size_t s = 0; s < _net.size(); ++s) {
+      _net[s]->EvaluateRegion(region);
+    }
+    for(size_t s = 0; s < _net.size(); ++s) {
+      _net[s]->WriteRegionOutputs(region, cycle);
+    }
+
+    _SetClock(region, cycle + 1);
+  }
+}
+
+void ParallelEngine::Release( int time )
+{
+  int const cycle = _clock[_regions * CLOCK_STRIDE];
+  if(cycle - _base != time - 1) {
+    // the traffic manager restarted its clock
+    Sync();
+    _base = cycle - time + 1;
+  }
+  _SetClock(_regions, _base + time);
+}
+
+void ParallelEngine::Sync( )
+{
+  int const cycle = _clock[_regions * CLOCK_STRIDE];
+  for(int r = 0; r < _regions; ++r) {
+    _Wait(r, cycle);
+  }
+}
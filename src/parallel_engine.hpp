@@ -0,0 +1,112 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*parallel_engine.hpp
+ *
+ *Conservative parallel simulation of the network.  The routers are split
+ *into regions (Network::Partition), each advanced by a thread of its own
+ *together with the terminals of the nodes attached to its routers: the
+ *thread generates and injects their packets, returns credits and ejects
+ *flits (TrafficManager::_StepRegion).  Every region keeps its own clock,
+ *the number of cycles it has completed.  Since nothing sent on a channel
+ *of latency L in cycle t is seen before cycle t + L + 1, a region may run
+ *cycle t once every region feeding it has completed cycle t - L - 1 
+ *(lookahead L); regions joined by long channels thus synchronize rarely.
+ *The traffic manager releases cycles to the regions as it steps and only
+ *waits for them (Sync) where it reads or changes what they simulate: at
+ *the end of a sample period, before a link fault and while draining.
+ *Every router and terminal draws its random numbers from a stream of its
+ *own, so the results match a sequential run with random_streams set and
+ *do not depend on the number of regions.
+ */
+
+#ifndef _PARALLEL_ENGINE_HPP_
+#define _PARALLEL_ENGINE_HPP_
+
+#include <vector>
+#include <utility>
+#include <pthread.h>
+
+#include "config_utils.hpp"
+#include "network.hpp"
+
+using namespace std;
+
+class TrafficManager;
+
+class ParallelEngine {
+
+  vector<Network *> _net;
+  TrafficManager * _tm;
+
+  int _regions;
+  // per region: the regions it waits for, each with its lookahead, and
+  // the traffic manager (index _regions) with lookahead -1; region r may
+  // run cycle t once clock(q) >= t - lookahead
+  vector<vector<pair<int, int> > > _inputs;
+
+  // clocks, one cache line apart; the traffic manager's, at index 
+  // _regions, is the number of cycles it has released
+  static int const CLOCK_STRIDE = 16;
+  vector<int> _clock;
+
+  // cycle minus traffic manager time; changes only while all regions
+  // are caught up
+  int _base;
+  bool _stop;
+
+  vector<pthread_t> _threads;
+  vector<pair<ParallelEngine *, int> > _args;
+
+  static void * _Run( void * args );
+  void _Region( int region );
+  bool _Wait( int lp, int cycle );
+  inline int _Clock( int lp ) const {
+    return __atomic_load_n( &_clock[lp * CLOCK_STRIDE], __ATOMIC_ACQUIRE );
+  }
+  inline void _SetClock( int lp, int cycle ) {
+    __atomic_store_n( &_clock[lp * CLOCK_STRIDE], cycle, __ATOMIC_RELEASE );
+  }
+
+public:
+
+  ParallelEngine( Configuration const & config, vector<Network *> const & net,
+		  TrafficManager * tm );
+  ~ParallelEngine( );
+
+  inline int NumRegions( ) const { return _regions; }
+
+  // Let the regions run every cycle before traffic manager time `time`.
+  void Release( int time );
+
+  // Wait until every region has completed the released cycles, before 
+  // the traffic manager reads or changes what they simulate.
+  void Sync( );
+
+};
+
+#endif
@@ -28,29 +28,46 @@
 #ifndef _BUFFER_MONITOR_HPP_
 #define _BUFFER_MONITOR_HPP_
 
-#include <vector>
+#include <cassert>
 #include <iostream>
 
-using namespace std;
+#include "flit.hpp"
 
-class Flit;
+using namespace std;
 
+// Counts buffer reads and writes per input and class.  The counters are 
+// not owned by the monitor: they are a slice of the network's contiguous 
+// activity array, attached with Bind once the network is built.
 class BufferMonitor {
-  int  _cycles ;
   int  _inputs ;
   int  _classes ;
-  vector<int> _reads ;
-  vector<int> _writes ;
-  int index( int input, int cl ) const ;
+  int * _reads ;
+  int * _writes ;
+  inline int index( int input, int cl ) const {
+    assert((input >= 0) && (input < _inputs)); 
+    assert((cl >= 0) && (cl < _classes));
+    return cl + _classes * input ;
+  }
 public:
   BufferMonitor( int inputs, int classes ) ;
-  void cycle() ;
-  void write( int input, Flit const * f ) ;
-  void read( int input, Flit const * f ) ;
-  inline const vector<int> & GetReads() const {
+  // number of counters to reserve in the network's activity array
+  inline int Size() const {
+    return 2 * _inputs * _classes;
+  }
+  void Bind( int * counters ) ;
+  inline void write( int input, Flit const * f ) {
+    assert(_writes);
+    ++_writes[ index(input, f->cl) ] ;
+  }
+  inline void read( int input, Flit const * f ) {
+    assert(_reads);
+    ++_reads[ index(input, f->cl) ] ;
+  }
+  // indexed by cl + classes * input
+  inline int const * GetReads() const {
     return _reads;
   }
-  inline const vector<int> & GetWrites() const {
+  inline int const * GetWrites() const {
     return _writes;
   }
   inline int NumInputs() const {
@@ -60,7 +77,6 @@ public:
     return _classes;
   }
   void display(ostream & os) const;
-
 } ;
 
 ostream & operator<<( ostream & os, BufferMonitor const & obj ) ;
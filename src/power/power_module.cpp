@@ -25,11 +25,13 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <fstream>
+
 #include "power_module.hpp"
 #include "booksim_config.hpp"
 #include "buffer_monitor.hpp"
 #include "switch_monitor.hpp"
-#include "iq_router.hpp"
+#include "router.hpp"
 
 Power_Module::Power_Module(Network * n , const Configuration &config)
   : Module( 0, "power_module" ){
@@ -102,6 +104,9 @@ Power_Module::Power_Module(Network * n , const Configuration &config)
 
   ChannelPitch = 2.0 * MetalPitch ;
   CrossbarPitch = 2.0 * MetalPitch ;
+
+  epochTimeOffset = 0;
+  epochLastTime = 0;
 }
 
 Power_Module::~Power_Module(){
@@ -116,30 +121,44 @@ Power_Module::~Power_Module(){
 
 void Power_Module::calcChannel(const FlitChannel* f){
   double channelLength = f->GetLatency()* wire_length;
-  wire const this_wire = wireOptimize(channelLength);
-  double const & K = this_wire.K;
-  double const & N = this_wire.N;
-  double const & M = this_wire.M;
-  //area
-  channelArea += areaChannel(K,N,M);
+  map<double, channel_group>::iterator iter = channel_groups.find(channelLength);
+  if(iter == channel_groups.end()){
+    channel_group g;
+    g.length = channelLength;
+    g.w = &wireOptimize(channelLength);
+    g.count = 0;
+    g.activity = 0;
+    iter = channel_groups.insert(make_pair(channelLength, g)).first;
+  }
+  channel_group & g = iter->second;
+  g.count += 1.0;
 
-  //activity factor;
-  const vector<int> temp = f->GetActivity();
-  vector<double> a(classes);
+  //activity factor; all power terms are linear in it, so only the sum over
+  //classes is kept
+  int const * const temp = f->GetActivity();
   for(int i = 0; i< classes; i++){
-
-    a[i] = ((double)temp[i])/totalTime;
+    g.activity += ((double)temp[i])/totalTime;
   }
+}
 
-  //power calculation
-  double const bitPower = powerRepeatedWire(channelLength, K,M,N);
-
-  channelClkPower += powerWireClk(M,channel_width);
-  for(int i = 0; i< classes; i++){
-    channelWirePower += bitPower * a[i]*channel_width;
-    channelDFFPower += powerWireDFF(M, channel_width, a[i]);
+void Power_Module::evalChannels(){
+  for(map<double, channel_group>::const_iterator iter = channel_groups.begin();
+      iter != channel_groups.end(); ++iter){
+    channel_group const & g = iter->second;
+    double const & K = g.w->K;
+    double const & N = g.w->N;
+    double const & M = g.w->M;
+    //area
+    channelArea += g.count * areaChannel(K,N,M);
+
+    //power calculation
+    double const bitPower = powerRepeatedWire(g.length, K,M,N);
+
+    channelClkPower += g.count * powerWireClk(M,channel_width);
+    channelWirePower += bitPower * g.activity * channel_width;
+    channelDFFPower += powerWireDFF(M, channel_width, g.activity);
+    channelLeakPower += g.count * powerRepeatedWireLeak(K,M,N)*channel_width;
   }
-  channelLeakPower+= powerRepeatedWireLeak(K,M,N)*channel_width;
 }
 
 wire const & Power_Module::wireOptimize(double L){
@@ -222,30 +241,35 @@ double Power_Module::powerWireDFF(double M, double W, double alpha){
 //Memory
 //////////////////////////////////////////////////////////////
 void Power_Module::calcBuffer(const BufferMonitor *bm){
-  double depth = numVC * depthVC  ;
-  double Pleak = powerMemoryBitLeak( depth ) * channel_width ;
-  //area
-
-  const vector<int> reads = bm->GetReads();
-  const vector<int> writes = bm->GetWrites();
+  int const * const reads = bm->GetReads();
+  int const * const writes = bm->GetWrites();
   for(int i = 0; i<bm->NumInputs(); i++){
-    inputArea += areaInputModule( depth );
-    inputLeakagePower += Pleak ;
+    bufferInputs += 1.0;
     for(int j = 0; j< classes; j++){
       double ar = ((double)reads[i* classes+j])/totalTime;
       double aw = ((double)writes[i* classes+j])/totalTime;
       if(ar>1 ||aw >1){
 	cout<<"activity factor is greater than one, soemthing is stomping memory\n"; exit(-1);
       }
-      double Pwl =  powerWordLine( channel_width, depth) ;
-      double Prd = powerMemoryBitRead( depth ) * channel_width ;
-      double Pwr = powerMemoryBitWrite( depth ) * channel_width ; 
-      inputReadPower    += ar * ( Pwl + Prd ) ;
-      inputWritePower   += aw * ( Pwl + Pwr ) ;
+      bufferReads += ar;
+      bufferWrites += aw;
     }
   }
 }
 
+void Power_Module::evalBuffers(){
+  double depth = numVC * depthVC  ;
+  double Pleak = powerMemoryBitLeak( depth ) * channel_width ;
+  //area
+  inputArea += bufferInputs * areaInputModule( depth );
+  inputLeakagePower += bufferInputs * Pleak ;
+
+  double Pwl =  powerWordLine( channel_width, depth) ;
+  double Prd = powerMemoryBitRead( depth ) * channel_width ;
+  double Pwr = powerMemoryBitWrite( depth ) * channel_width ; 
+  inputReadPower    += bufferReads * ( Pwl + Prd ) ;
+  inputWritePower   += bufferWrites * ( Pwl + Pwr ) ;
+}
 
 double Power_Module::powerWordLine(double memoryWidth, double memoryDepth){
   // wordline capacitance
@@ -300,38 +324,61 @@ double Power_Module::powerMemoryBitLeak(double memoryDepth ){
 //////////////////////////////////////////////////////////////
 
 void Power_Module::calcSwitch(const SwitchMonitor* sm){
+  pair<int, int> const shape(sm->NumInputs(), sm->NumOutputs());
+  map<pair<int, int>, switch_group>::iterator iter = switch_groups.find(shape);
+  if(iter == switch_groups.end()){
+    switch_group g;
+    g.inputs = shape.first;
+    g.outputs = shape.second;
+    g.count = 0;
+    g.activity = 0;
+    for(int q = 0; q < 4; q++){
+      g.quadrant[q] = 0;
+    }
+    iter = switch_groups.insert(make_pair(shape, g)).first;
+  }
+  switch_group & g = iter->second;
+  g.count += 1.0;
 
-  switchArea += areaCrossbar(sm->NumInputs(), sm->NumOutputs());
-  outputArea += areaOutputModule(sm->NumOutputs());
-  switchPowerLeak += powerCrossbarLeak(channel_width, sm->NumInputs(), sm->NumOutputs());
-
-  const vector<int> activity = sm->GetActivity();
-  vector<double> type_activity(classes);
+  int const * const activity = sm->GetActivity();
 
   for(int i = 0; i<sm->NumOutputs(); i++){
-    for(int k = 0; k<classes; k++){
-      type_activity[k] = 0;
-    }
     for(int j = 0; j<sm->NumInputs(); j++){
+      //crossbar traversal power only depends on which half of the inputs
+      //and outputs the connection is in
+      int const q = ((j < g.inputs/2) ? 1 : 0) + ((i < g.outputs/2) ? 2 : 0);
       for(int k  = 0; k<classes; k++){
 	double a = activity[k+classes*(i+sm->NumOutputs()*j)];
 	a = a/totalTime;
 	if(a>1){
 	  cout<<"Switcht activity factor is greater than 1!!!\n";exit(-1);
 	}
-	double Px = powerCrossbar(channel_width, sm->NumInputs(),sm->NumOutputs(),j,i);
-	switchPower += a*channel_width*Px;
-	switchPowerCtrl += a *powerCrossbarCtrl(channel_width,  sm->NumInputs(),sm->NumOutputs());
-	type_activity[k]+=a;
+	g.quadrant[q] += a;
+	g.activity += a;
       }
     }
-    outputPowerClk += powerWireClk( 1, channel_width ) ;
-    for(int k = 0; k<classes; k++){
-      outputPower += type_activity[k] * powerWireDFF( 1, channel_width, 1.0 ) ;
-      outputCtrlPower += type_activity[k] * powerOutputCtrl(channel_width ) ;
-    }
   }
+}
 
+void Power_Module::evalSwitches(){
+  for(map<pair<int, int>, switch_group>::const_iterator iter = switch_groups.begin();
+      iter != switch_groups.end(); ++iter){
+    switch_group const & g = iter->second;
+    switchArea += g.count * areaCrossbar(g.inputs, g.outputs);
+    outputArea += g.count * areaOutputModule(g.outputs);
+    switchPowerLeak += g.count * powerCrossbarLeak(channel_width, g.inputs, g.outputs);
+
+    for(int q = 0; q < 4; q++){
+      double const from = (q & 1) ? 0 : g.inputs;
+      double const to = (q & 2) ? 0 : g.outputs;
+      double Px = powerCrossbar(channel_width, g.inputs, g.outputs, from, to);
+      switchPower += g.quadrant[q]*channel_width*Px;
+    }
+    switchPowerCtrl += g.activity * powerCrossbarCtrl(channel_width, g.inputs, g.outputs);
+    outputPowerClk += g.count * g.outputs * powerWireClk( 1, channel_width ) ;
+    outputPower += g.activity * powerWireDFF( 1, channel_width, 1.0 ) ;
+    outputCtrlPower += g.activity * powerOutputCtrl(channel_width ) ;
+  }
 }
 
 double Power_Module::powerCrossbar(double width, double inputs, double outputs, double from, double to){
@@ -445,8 +492,7 @@ double Power_Module:: areaOutputModule(double Outputs) {
     return channel_width * Adff * MetalPitch * MetalPitch ;
 }
 
-void Power_Module::run(){
-  totalTime = GetSimTime();
+void Power_Module::evaluate(){
   channelWirePower=0;
   channelClkPower=0;
   channelDFFPower=0;
@@ -464,9 +510,25 @@ void Power_Module::run(){
   switchArea=0;
   inputArea=0;
   outputArea=0;
+
+  evalChannels();
+  evalBuffers();
+  evalSwitches();
+}
+
+void Power_Module::run(){
+  totalTime = GetSimTime();
   maxInputPort = 0;
   maxOutputPort = 0;
 
+  //one pass over the network collects the activity, grouped by everything
+  //the power and area functions depend on other than the channel width
+  channel_groups.clear();
+  switch_groups.clear();
+  bufferInputs = 0;
+  bufferReads = 0;
+  bufferWrites = 0;
+
   vector<FlitChannel *> inject = net->GetInject();
   vector<FlitChannel *> eject = net->GetEject();
   vector<FlitChannel *> chan = net->GetChannels();
@@ -485,12 +547,17 @@ void Power_Module::run(){
 
   vector<Router*> routers = net->GetRouters();
   for(size_t i = 0; i < routers.size(); i++){
-    IQRouter* temp = dynamic_cast<IQRouter*>(routers[i]);
-    const BufferMonitor * bm = temp->GetBufferMonitor();
-    calcBuffer(bm);
-    const SwitchMonitor * sm = temp->GetSwitchMonitor();
-    calcSwitch(sm);
+    const BufferMonitor * bm = routers[i]->GetBufferMonitor();
+    if(bm){
+      calcBuffer(bm);
+    }
+    const SwitchMonitor * sm = routers[i]->GetSwitchMonitor();
+    if(sm){
+      calcSwitch(sm);
+    }
   }
+
+  evaluate();
   
   double totalpower =  channelWirePower+channelClkPower+channelDFFPower+channelLeakPower+ inputReadPower+inputWritePower+inputLeakagePower+ switchPower+switchPowerCtrl+switchPowerLeak+outputPower+outputPowerClk+outputCtrlPower;
   double totalarea =  channelArea+switchArea+inputArea+outputArea;
@@ -526,7 +593,238 @@ void Power_Module::run(){
   cout<< "- Total Area:    "<<totalarea<<endl;
   cout<< "-----------------------------------------\n" ;
 
+  if(channel_sweep > 0){
+    sweep();
+  }
+}
 
+void Power_Module::sweep(){
+  double const width = channel_width;
 
+  ofstream * out = NULL;
+  if(output_file_name != ""){
+    out = new ofstream(output_file_name.c_str());
+    if(!out->is_open()){
+      cout<<"Error: Unable to open power output file: "<<output_file_name<<endl;
+      exit(-1);
+    }
+    *out<<"width\tchannel_power\tinput_power\tswitch_power\toutput_power\ttotal_power"
+	<<"\tchannel_area\tswitch_area\tinput_area\toutput_area\ttotal_area\n";
+  }
 
+  cout<< "-----------------------------------------\n" ;
+  cout<< "- OCN Channel Width Sweep\n" ;
+  cout<< "- Width\tTotal Power\tTotal Area\n" ;
+  for(channel_width = width; channel_width > 0; channel_width -= channel_sweep){
+    evaluate();
+    double const chPower = channelWirePower+channelClkPower+channelDFFPower+channelLeakPower;
+    double const inPower = inputReadPower+inputWritePower+inputLeakagePower;
+    double const swPower = switchPower+switchPowerCtrl+switchPowerLeak;
+    double const outPower = outputPower+outputPowerClk+outputCtrlPower;
+    double const totalpower = chPower + inPower + swPower + outPower;
+    double const totalarea = channelArea+switchArea+inputArea+outputArea;
+    cout<< "- "<<channel_width<<"\t"<<totalpower<<"\t"<<totalarea<<"\n" ;
+    if(out){
+      *out<<channel_width<<"\t"<<chPower<<"\t"<<inPower<<"\t"<<swPower<<"\t"<<outPower
+	  <<"\t"<<totalpower<<"\t"<<channelArea<<"\t"<<switchArea<<"\t"<<inputArea
+	  <<"\t"<<outputArea<<"\t"<<totalarea<<"\n";
+    }
+  }
+  cout<< "-----------------------------------------" <<endl;
+
+  delete out;
+  channel_width = width;
+  evaluate();
+}
+
+//////////////////////////////////////////////////////////////////
+//incremental accounting
+//////////////////////////////////////////////////////////////////
+
+void Power_Module::InitEpochs(){
+  //the power functions give the power at an activity factor of one, i.e.
+  //for one event per cycle; one event therefore costs that power times tCLK
+  vector<FlitChannel *> inject = net->GetInject();
+  vector<FlitChannel *> eject = net->GetEject();
+  vector<FlitChannel *> chan = net->GetChannels();
+  epochChannels.clear();
+  epochChannels.insert(epochChannels.end(), inject.begin(), inject.begin() + net->NumNodes());
+  epochChannels.insert(epochChannels.end(), eject.begin(), eject.begin() + net->NumNodes());
+  epochChannels.insert(epochChannels.end(), chan.begin(), chan.begin() + net->NumChannels());
+
+  size_t const channels = epochChannels.size();
+  channelFlitEnergy.resize(channels);
+  channelStaticPower.resize(channels);
+  channelLastFlits.resize(channels);
+  channelEnergy.assign(channels, 0.0);
+  for(size_t c = 0; c < channels; c++){
+    FlitChannel const * const f = epochChannels[c];
+    double const channelLength = f->GetLatency() * wire_length;
+    wire const this_wire = wireOptimize(channelLength);
+    double const & K = this_wire.K;
+    double const & N = this_wire.N;
+    double const & M = this_wire.M;
+    channelFlitEnergy[c] = (powerRepeatedWire(channelLength, K, M, N) * channel_width +
+			    powerWireDFF(M, channel_width, 1.0)) * tCLK;
+    channelStaticPower[c] = powerWireClk(M, channel_width) +
+      powerRepeatedWireLeak(K, M, N) * channel_width;
+    int const * const temp = f->GetActivity();
+    channelLastFlits[c] = 0;
+    for(int i = 0; i < classes; i++){
+      channelLastFlits[c] += temp[i];
+    }
+  }
+
+  vector<Router*> routers = net->GetRouters();
+  size_t const nrouters = routers.size();
+  epochBuffers.resize(nrouters);
+  epochSwitches.resize(nrouters);
+  bufferReadEnergy.assign(nrouters, 0.0);
+  bufferWriteEnergy.assign(nrouters, 0.0);
+  routerStaticPower.assign(nrouters, 0.0);
+  switchEnergy.assign(nrouters, vector<double>());
+  bufferLastReads.assign(nrouters, vector<long long>());
+  bufferLastWrites.assign(nrouters, vector<long long>());
+  switchLastEvents.assign(nrouters, vector<long long>());
+  routerEnergy.assign(nrouters, 0.0);
+  double const depth = numVC * depthVC;
+  for(size_t r = 0; r < nrouters; r++){
+    BufferMonitor const * const bm = routers[r]->GetBufferMonitor();
+    epochBuffers[r] = bm;
+    if(bm){
+      double const Pwl = powerWordLine(channel_width, depth);
+      bufferReadEnergy[r] = (Pwl + powerMemoryBitRead(depth) * channel_width) * tCLK;
+      bufferWriteEnergy[r] = (Pwl + powerMemoryBitWrite(depth) * channel_width) * tCLK;
+      routerStaticPower[r] += powerMemoryBitLeak(depth) * channel_width * bm->NumInputs();
+      bufferLastReads[r].assign(bm->NumInputs(), 0);
+      bufferLastWrites[r].assign(bm->NumInputs(), 0);
+      int const * const reads = bm->GetReads();
+      int const * const writes = bm->GetWrites();
+      for(int i = 0; i < bm->NumInputs(); i++){
+	for(int j = 0; j < classes; j++){
+	  bufferLastReads[r][i] += reads[i * classes + j];
+	  bufferLastWrites[r][i] += writes[i * classes + j];
+	}
+      }
+    }
+    SwitchMonitor const * const sm = routers[r]->GetSwitchMonitor();
+    epochSwitches[r] = sm;
+    if(sm){
+      int const inputs = sm->NumInputs();
+      int const outputs = sm->NumOutputs();
+      routerStaticPower[r] += powerCrossbarLeak(channel_width, inputs, outputs) +
+	outputs * powerWireClk(1, channel_width);
+      //crossbar control, output retiming and output control are the same
+      //for every traversal
+      double const common = powerCrossbarCtrl(channel_width, inputs, outputs) +
+	powerWireDFF(1, channel_width, 1.0) + powerOutputCtrl(channel_width);
+      switchEnergy[r].resize(inputs * outputs);
+      switchLastEvents[r].assign(inputs * outputs, 0);
+      int const * const activity = sm->GetActivity();
+      for(int j = 0; j < inputs; j++){
+	for(int i = 0; i < outputs; i++){
+	  switchEnergy[r][j * outputs + i] = 
+	    (channel_width * powerCrossbar(channel_width, inputs, outputs, j, i) +
+	     common) * tCLK;
+	  for(int k = 0; k < classes; k++){
+	    switchLastEvents[r][j * outputs + i] += activity[k + classes * (i + outputs * j)];
+	  }
+	}
+      }
+    }
+  }
+}
+
+void Power_Module::EpochHeader(ostream & os) const {
+  os << "time,subnet,total,channels,routers";
+  for(size_t r = 0; r < routerEnergy.size(); r++){
+    os << ",r" << r;
+  }
+  int const nodes = net->NumNodes();
+  for(size_t c = 0; c < channelEnergy.size(); c++){
+    if((int)c < nodes){
+      os << ",inj" << c;
+    } else if((int)c < 2 * nodes){
+      os << ",ej" << (c - nodes);
+    } else {
+      os << ",ch" << (c - 2 * nodes);
+    }
+  }
+  os << endl;
+}
+
+void Power_Module::Epoch(ostream & os, int subnet, long long time, int cycles){
+  //keep the time axis monotonic across back-to-back simulations
+  long long t = epochTimeOffset + time;
+  if(t <= epochLastTime){
+    epochTimeOffset = epochLastTime;
+    t = epochLastTime + time;
+  }
+  epochLastTime = t;
+
+  double const staticTime = cycles * tCLK;
+
+  double channels = 0.0;
+  for(size_t c = 0; c < epochChannels.size(); c++){
+    int const * const temp = epochChannels[c]->GetActivity();
+    long long flits = 0;
+    for(int i = 0; i < classes; i++){
+      flits += temp[i];
+    }
+    channelEnergy[c] = (double)(flits - channelLastFlits[c]) * channelFlitEnergy[c] +
+      channelStaticPower[c] * staticTime;
+    channelLastFlits[c] = flits;
+    channels += channelEnergy[c];
+  }
+
+  double routers = 0.0;
+  for(size_t r = 0; r < routerEnergy.size(); r++){
+    double e = routerStaticPower[r] * staticTime;
+    BufferMonitor const * const bm = epochBuffers[r];
+    if(bm){
+      int const * const reads = bm->GetReads();
+      int const * const writes = bm->GetWrites();
+      for(int i = 0; i < bm->NumInputs(); i++){
+	long long rd = 0;
+	long long wr = 0;
+	for(int j = 0; j < classes; j++){
+	  rd += reads[i * classes + j];
+	  wr += writes[i * classes + j];
+	}
+	e += (double)(rd - bufferLastReads[r][i]) * bufferReadEnergy[r] +
+	  (double)(wr - bufferLastWrites[r][i]) * bufferWriteEnergy[r];
+	bufferLastReads[r][i] = rd;
+	bufferLastWrites[r][i] = wr;
+      }
+    }
+    SwitchMonitor const * const sm = epochSwitches[r];
+    if(sm){
+      int const * const activity = sm->GetActivity();
+      int const inputs = sm->NumInputs();
+      int const outputs = sm->NumOutputs();
+      for(int j = 0; j < inputs; j++){
+	for(int i = 0; i < outputs; i++){
+	  long long events = 0;
+	  for(int k = 0; k < classes; k++){
+	    events += activity[k + classes * (i + outputs * j)];
+	  }
+	  int const idx = j * outputs + i;
+	  e += (double)(events - switchLastEvents[r][idx]) * switchEnergy[r][idx];
+	  switchLastEvents[r][idx] = events;
+	}
+      }
+    }
+    routerEnergy[r] = e;
+    routers += e;
+  }
+
+  os << t << ',' << subnet << ',' << (channels + routers) 
+     << ',' << channels << ',' << routers;
+  for(size_t r = 0; r < routerEnergy.size(); r++){
+    os << ',' << routerEnergy[r];
+  }
+  for(size_t c = 0; c < channelEnergy.size(); c++){
+    os << ',' << channelEnergy[c];
+  }
+  os << '\n';
 }
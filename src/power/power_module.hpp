@@ -44,6 +44,25 @@ struct wire{
   double N;
 };
 
+//channels of the same length share their wire design and per-width power
+struct channel_group{
+  double length;
+  wire const * w;
+  double count;
+  //sum of activity factors over all channels and classes
+  double activity;
+};
+
+//routers with the same number of inputs and outputs share their crossbar
+struct switch_group{
+  double inputs;
+  double outputs;
+  double count;
+  double activity;
+  //activity by input half (bit 0: lower half) and output half (bit 1)
+  double quadrant[4];
+};
+
 class Power_Module : public Module {
 
 protected:
@@ -65,6 +84,13 @@ protected:
   //store the property of wires based on length
   map<double, wire> wire_map;
 
+  //activity collected once by run() and evaluated for every channel width
+  map<double, channel_group> channel_groups;
+  map<pair<int, int>, switch_group> switch_groups;
+  double bufferInputs;
+  double bufferReads;
+  double bufferWrites;
+
   //////////////////////////////////Constants/////////////////////////////
   //wire length in (mm)
   double wire_length;
@@ -142,10 +168,39 @@ protected:
   double maxOutputPort;
 
 
+  ////////////////////////
+
+  /////////////incremental (per-epoch) accounting///////////////////
+  //per-event energies [J] and static power [W], computed once by InitEpochs
+  vector<FlitChannel const *> epochChannels;
+  vector<double> channelFlitEnergy;
+  vector<double> channelStaticPower;
+  vector<long long> channelLastFlits;
+
+  vector<BufferMonitor const *> epochBuffers;
+  vector<SwitchMonitor const *> epochSwitches;
+  vector<double> bufferReadEnergy;
+  vector<double> bufferWriteEnergy;
+  vector<double> routerStaticPower;
+  //indexed by router, then by input * outputs + output
+  vector<vector<double> > switchEnergy;
+  //previous reads/writes per router input, traversals per input/output pair
+  vector<vector<long long> > bufferLastReads;
+  vector<vector<long long> > bufferLastWrites;
+  vector<vector<long long> > switchLastEvents;
+
+  //energy accumulated per router and per channel over the current epoch
+  vector<double> routerEnergy;
+  vector<double> channelEnergy;
+
+  long long epochTimeOffset;
+  long long epochLastTime;
+
   ////////////////////////
 
   //channels
   void calcChannel(const FlitChannel * f);
+  void evalChannels();
   wire const & wireOptimize(double l);
   double powerRepeatedWire(double L, double K, double M, double N);
   double powerRepeatedWireLeak (double K, double M, double N);
@@ -154,6 +209,7 @@ protected:
   
   //memory
   void calcBuffer(const BufferMonitor *bm);
+  void evalBuffers();
   double powerWordLine(double memoryWidth, double memoryDepth);
   double powerMemoryBitRead(double memoryDepth);
   double powerMemoryBitWrite(double memoryDepth);
@@ -161,6 +217,7 @@ protected:
 
   //switch
   void calcSwitch(const SwitchMonitor *sm);
+  void evalSwitches();
   double powerCrossbar(double width, double inputs, double outputs, double from, double to);
   double powerCrossbarCtrl(double width, double inputs, double outputs);
   double powerCrossbarLeak (double width, double inputs, double outputs);
@@ -170,6 +227,12 @@ protected:
 
   //area
 
+  //compute all results for the current channel_width from the collected
+  //activity
+  void evaluate();
+  //evaluate every width from channel_width down in steps of channel_sweep
+  void sweep();
+
   double areaChannel (double K, double N, double M);
   double areaCrossbar(double Inputs, double Outputs) ;
   double areaInputModule(double Words) ;
@@ -181,6 +244,15 @@ public:
 
   void run();
 
+  //precompute per-event energies and snapshot all activity counters; the 
+  //next Epoch call accounts for activity from this point on
+  void InitEpochs();
+  //write the CSV column names for the rows written by Epoch
+  void EpochHeader(ostream & os) const;
+  //account for the energy spent over the last cycles cycles, ending at time,
+  //and write it as one row tagged with the given subnet
+  void Epoch(ostream & os, int subnet, long long time, int cycles);
+
 
 };
 #endif
@@ -27,26 +27,12 @@
 
 #include "switch_monitor.hpp"
 
-#include "flit.hpp"
-
 SwitchMonitor::SwitchMonitor( int inputs, int outputs, int classes )
-: _cycles(0), _inputs(inputs), _outputs(outputs), _classes(classes) {
-  _event.resize(inputs * outputs * classes, 0) ;
-}
-
-int SwitchMonitor::index( int input, int output, int cl ) const {
-  assert((input >= 0) && (input < _inputs));
-  assert((output >= 0) && (output < _outputs));
-  assert((cl >= 0) && (cl < _classes));
-  return cl + _classes * ( output + _outputs * input ) ;
-}
-
-void SwitchMonitor::cycle() {
-  _cycles++ ;
+: _inputs(inputs), _outputs(outputs), _classes(classes), _event(NULL) {
 }
 
-void SwitchMonitor::traversal( int input, int output, Flit const * f ) {
-  _event[ index( input, output, f->cl) ]++ ;
+void SwitchMonitor::Bind( int * counters ) {
+  _event = counters ;
 }
 
 void SwitchMonitor::display(ostream & os) const {
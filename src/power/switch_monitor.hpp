@@ -28,24 +28,35 @@
 #ifndef _SWITCH_MONITOR_HPP_
 #define _SWITCH_MONITOR_HPP_
 
-#include <vector>
+#include <cassert>
 #include <iostream>
 
-using namespace std;
+#include "flit.hpp"
 
-class Flit;
+using namespace std;
 
+// Counts crossbar traversals per input, output and class.  Like 
+// BufferMonitor, the counters are a slice of the network's activity array.
 class SwitchMonitor {
-  int  _cycles ;
   int  _inputs ;
   int  _outputs ;
   int  _classes ;
-  vector<int> _event ;
-  int index( int input, int output, int cl ) const ;
+  int * _event ;
+  inline int index( int input, int output, int cl ) const {
+    assert((input >= 0) && (input < _inputs));
+    assert((output >= 0) && (output < _outputs));
+    assert((cl >= 0) && (cl < _classes));
+    return cl + _classes * ( output + _outputs * input ) ;
+  }
 public:
   SwitchMonitor( int inputs, int outputs, int classes ) ;
-  void cycle() ;
-  vector<int> const & GetActivity() const {
+  // number of counters to reserve in the network's activity array
+  inline int Size() const {
+    return _inputs * _outputs * _classes;
+  }
+  void Bind( int * counters ) ;
+  // indexed by cl + classes * ( output + outputs * input )
+  inline int const * GetActivity() const {
     return _event;
   }
   inline int const & NumInputs() const {
@@ -57,7 +68,10 @@ public:
   inline int const & NumClasses() const {
     return _classes;
   }
-  void traversal( int input, int output, Flit const * f ) ;
+  inline void traversal( int input, int output, Flit const * f ) {
+    assert(_event);
+    ++_event[ index( input, output, f->cl) ] ;
+  }
   void display(ostream & os) const;
 } ;
 
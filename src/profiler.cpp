@@ -0,0 +1,134 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iomanip>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "profiler.hpp"
+
+vector<Profiler::Stage> Profiler::_stages;
+
+Profiler::tick_t Profiler::_start_ticks = 0;
+double Profiler::_start_wall = 0.0;
+
+double Profiler::_Wall( )
+{
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return (double)tv.tv_sec + 1e-6 * (double)tv.tv_usec;
+}
+
+int Profiler::Register( string const & name )
+{
+  for(size_t i = 0; i < _stages.size(); ++i) {
+    if(_stages[i].name == name) {
+      return i;
+    }
+  }
+  size_t const pos = name.rfind('/');
+  int const parent = (pos == string::npos) ? -1 : Register(name.substr(0, pos));
+  Stage s;
+  s.name = name;
+  s.parent = parent;
+  s.ticks = 0;
+  s.calls = 0;
+  int const id = _stages.size();
+  _stages.push_back(s);
+  if(parent >= 0) {
+    _stages[parent].children.push_back(id);
+  }
+  return id;
+}
+
+void Profiler::Start( )
+{
+  for(size_t i = 0; i < _stages.size(); ++i) {
+    _stages[i].ticks = 0;
+    _stages[i].calls = 0;
+  }
+  _start_wall = _Wall( );
+  _start_ticks = Now( );
+}
+
+void Profiler::_Display( ostream & os, int stage, int depth, 
+			 tick_t total, double sec_per_tick )
+{
+  Stage const & s = _stages[stage];
+  string const label = string(2 * depth, ' ') + s.name.substr(s.name.rfind('/') + 1);
+  os << "  " << left << setw(28) << label << right
+     << setw(12) << fixed << setprecision(3) << (double)s.ticks * sec_per_tick
+     << setw(9) << setprecision(1) << (100.0 * (double)s.ticks / (double)total) << "%"
+     << setw(14) << s.calls << endl;
+  for(size_t i = 0; i < s.children.size(); ++i) {
+    _Display( os, s.children[i], depth + 1, total, sec_per_tick );
+  }
+}
+
+void Profiler::Display( ostream & os, long long cycles, long long flits )
+{
+  tick_t const total = Now( ) - _start_ticks;
+  double const wall = _Wall( ) - _start_wall;
+  if((total == 0) || (wall <= 0.0)) {
+    return;
+  }
+  double const sec_per_tick = wall / (double)total;
+
+  ios::fmtflags const flags = os.flags();
+  streamsize const prec = os.precision();
+
+  os << "====== Profile ======" << endl;
+  os << "  " << left << setw(28) << "stage" << right 
+     << setw(12) << "seconds" << setw(10) << "share" 
+     << setw(14) << "calls" << endl;
+  tick_t accounted = 0;
+  for(size_t i = 0; i < _stages.size(); ++i) {
+    if(_stages[i].parent < 0) {
+      _Display( os, i, 0, total, sec_per_tick );
+      accounted += _stages[i].ticks;
+    }
+  }
+  tick_t const other = (accounted < total) ? (total - accounted) : 0;
+  os << "  " << left << setw(28) << "other" << right
+     << setw(12) << fixed << setprecision(3) << (double)other * sec_per_tick
+     << setw(9) << setprecision(1) << (100.0 * (double)other / (double)total) << "%" 
+     << endl;
+  os << "Wall time = " << setprecision(3) << wall << " s" << endl;
+  os << "Simulated cycles = " << cycles << endl;
+  os << "Cycles per second = " << setprecision(1) << ((double)cycles / wall) << endl;
+  os << "Delivered flits = " << flits << endl;
+  os << "Flits per second = " << setprecision(1) << ((double)flits / wall) << endl;
+
+  // ru_maxrss is reported in kilobytes on Linux
+  struct rusage usage;
+  if(getrusage( RUSAGE_SELF, &usage ) == 0) {
+    os << "Peak RSS = " << usage.ru_maxrss << " kB" << endl;
+  }
+
+  os.flags(flags);
+  os.precision(prec);
+}
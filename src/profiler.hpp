@@ -0,0 +1,129 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*profiler.hpp
+ *
+ *Optional wall-clock profiler for the simulator itself.  Stages are named
+ *with '/'-separated paths ("evaluate/iq/vc_alloc"), so that nested timers
+ *form a tree that is printed with inclusive times at the end of a run.
+ *Timing is only done when the profile option is set; otherwise a
+ *ProfileScope costs a single branch.
+ */
+
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#include "globals.hpp"
+
+using namespace std;
+
+class Profiler {
+
+public:
+
+  typedef unsigned long long tick_t;
+
+private:
+
+  struct Stage {
+    string name;
+    int parent;
+    vector<int> children;
+    tick_t ticks;
+    long long calls;
+  };
+
+  static vector<Stage> _stages;
+
+  static tick_t _start_ticks;
+  static double _start_wall;
+
+  static double _Wall( );
+  static void _Display( ostream & os, int stage, int depth, 
+			tick_t total, double sec_per_tick );
+
+public:
+
+  static inline tick_t Now( ) {
+#if defined(__i386__) || defined(__x86_64__)
+    return __rdtsc( );
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (tick_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+  }
+
+  // returns the id of the named stage, creating it (and its parents) if 
+  // necessary
+  static int Register( string const & name );
+
+  static inline void Add( int stage, tick_t ticks ) {
+    _stages[stage].ticks += ticks;
+    ++_stages[stage].calls;
+  }
+
+  // clear all stage times and start the overall clock
+  static void Start( );
+
+  // prints the stage tree followed by overall throughput figures for the 
+  // given number of simulated cycles and delivered flits
+  static void Display( ostream & os, long long cycles, long long flits );
+
+};
+
+class ProfileScope {
+
+  int _stage;
+  Profiler::tick_t _start;
+
+public:
+
+  inline ProfileScope( int stage ) : _stage(gProfile ? stage : -1), _start(0) {
+    if(_stage >= 0) {
+      _start = Profiler::Now( );
+    }
+  }
+  inline ~ProfileScope( ) {
+    if(_stage >= 0) {
+      Profiler::Add( _stage, Profiler::Now( ) - _start );
+    }
+  }
+
+};
+
+#endif
@@ -33,6 +33,17 @@ extern long ran_x[];
 extern double ran_u[];
 #define KK 100
 
+__thread unsigned long long * gRandomStream = 0;
+
+unsigned long long RandomStreamSeed( unsigned long long seed ) {
+  // splitmix64 spreads nearby seeds apart and never yields zero here
+  unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return z ? z : 1;
+}
+
 void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u ) {
   save_x.assign(ran_x, ran_x + KK);
   save_u.assign(ran_u, ran_u + KK);
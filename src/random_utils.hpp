@@ -60,6 +60,24 @@ inline double RandomFloat( double max ) {
   return ( ranf_next( ) * max );
 }
 
+// Returns the initial state of a random stream (a 64-bit xorshift
+// generator) derived from seed; distinct seeds give unrelated streams
+unsigned long long RandomStreamSeed( unsigned long long seed );
+
+// stream the calling thread draws from; NULL on code that uses the
+// shared generator.  The network points it at a router's own stream while
+// that router runs, so router draws do not depend on evaluation order.
+extern __thread unsigned long long * gRandomStream;
+
+inline unsigned long long RandomStreamNext( ) {
+  unsigned long long x = *gRandomStream;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *gRandomStream = x;
+  return x * 2685821657736338717ULL;
+}
+
 // Saves the current generator state
 void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u );
 
@@ -28,7 +28,12 @@
 #define main rng_double_main
 #include "rng-double.c"
 
+#include "random_utils.hpp"
+
 double ranf_next( )
 {
+  if(gRandomStream) {
+    return (double)(RandomStreamNext( ) >> 11) * (1.0 / 9007199254740992.0);
+  }
   return ranf_arr_next( );
 }
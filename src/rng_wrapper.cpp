@@ -28,7 +28,13 @@
 #define main rng_main
 #include "rng.c"
 
+#include "random_utils.hpp"
+
 long ran_next( )
 {
+  if(gRandomStream) {
+    // same range as the shared generator, [0, 2^30)
+    return (long)(RandomStreamNext( ) >> 34);
+  }
   return ran_arr_next( );
 }
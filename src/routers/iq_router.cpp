@@ -46,6 +46,8 @@
 #include "allocator.hpp"
 #include "switch_monitor.hpp"
 #include "buffer_monitor.hpp"
+#include "profiler.hpp"
+#include "event_trace.hpp"
 
 IQRouter::IQRouter( Configuration const & config, Module *parent, 
 		    string const & name, int id, int inputs, int outputs )
@@ -62,6 +64,12 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
   _spec_check_cred = (config.GetInt("spec_check_cred") > 0);
   _spec_mask_by_reqs = (config.GetInt("spec_mask_by_reqs") > 0);
 
+  _prof_route = Profiler::Register("evaluate/iq/route");
+  _prof_vc_alloc = Profiler::Register("evaluate/iq/vc_alloc");
+  _prof_sw_alloc = Profiler::Register("evaluate/iq/sw_alloc");
+  _prof_switch = Profiler::Register("evaluate/iq/switch");
+  _prof_update = Profiler::Register("evaluate/iq/update");
+
   _routing_delay    = config.GetInt( "routing_delay" );
   _vc_alloc_delay   = config.GetInt( "vc_alloc_delay" );
   if(!_vc_alloc_delay) {
@@ -168,22 +176,26 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
   _switch_hold_out.resize(_outputs*_output_speedup, -1);
   _switch_hold_vc.resize(_inputs*_input_speedup, -1);
 
-  _bufferMonitor = new BufferMonitor(inputs, _classes);
-  _switchMonitor = new SwitchMonitor(inputs, outputs, _classes);
+  // activity monitors are only needed by the power model and activity dump
+  _bufferMonitor = NULL;
+  _switchMonitor = NULL;
+  if((config.GetInt("sim_power") > 0) || 
+     (config.GetStr("power_epoch_out") != "") ||
+     (config.GetInt("print_activity") > 0)) {
+    _bufferMonitor = new BufferMonitor(inputs, _classes);
+    _switchMonitor = new SwitchMonitor(inputs, outputs, _classes);
+  }
 
-#ifdef TRACK_FLOWS
-  for(int c = 0; c < _classes; ++c) {
-    _stored_flits[c].resize(_inputs, 0);
-    _active_packets[c].resize(_inputs, 0);
+  _track_flows = (config.GetInt("track_flows") > 0);
+  if(_track_flows) {
+    _outstanding_classes.resize(_outputs, vector<queue<int> >(_vcs));
   }
-  _outstanding_classes.resize(_outputs, vector<queue<int> >(_vcs));
-#endif
 }
 
 IQRouter::~IQRouter( )
 {
 
-  if(gPrintActivity) {
+  if(gPrintActivity && _bufferMonitor) {
     cout << Name() << ".bufferMonitor:" << endl ; 
     cout << *_bufferMonitor << endl ;
     
@@ -207,6 +219,20 @@ IQRouter::~IQRouter( )
   delete _bufferMonitor;
   delete _switchMonitor;
 }
+
+int IQRouter::NumActivityCounters( ) const
+{
+  if(!_bufferMonitor) {
+    return 0;
+  }
+  return _bufferMonitor->Size( ) + _switchMonitor->Size( );
+}
+
+void IQRouter::BindActivityCounters( int * counters )
+{
+  _bufferMonitor->Bind( counters );
+  _switchMonitor->Bind( counters + _bufferMonitor->Size( ) );
+}
   
 void IQRouter::AddOutputChannel(FlitChannel * channel, CreditChannel * backchannel)
 {
@@ -232,54 +258,63 @@ void IQRouter::_InternalStep( )
   _InputQueuing( );
   bool activity = !_proc_credits.empty();
 
-  if(!_route_vcs.empty())
+  if(!_route_vcs.empty()) {
+    ProfileScope prof(_prof_route);
     _RouteEvaluate( );
+  }
   if(_vc_allocator) {
+    ProfileScope prof(_prof_vc_alloc);
     _vc_allocator->Clear();
     if(!_vc_alloc_vcs.empty())
       _VCAllocEvaluate( );
   }
-  if(_hold_switch_for_packet) {
-    if(!_sw_hold_vcs.empty())
-      _SWHoldEvaluate( );
+  {
+    ProfileScope prof(_prof_sw_alloc);
+    if(_hold_switch_for_packet) {
+      if(!_sw_hold_vcs.empty())
+	_SWHoldEvaluate( );
+    }
+    _sw_allocator->Clear();
+    if(_spec_sw_allocator)
+      _spec_sw_allocator->Clear();
+    if(!_sw_alloc_vcs.empty())
+      _SWAllocEvaluate( );
   }
-  _sw_allocator->Clear();
-  if(_spec_sw_allocator)
-    _spec_sw_allocator->Clear();
-  if(!_sw_alloc_vcs.empty())
-    _SWAllocEvaluate( );
-  if(!_crossbar_flits.empty())
+  if(!_crossbar_flits.empty()) {
+    ProfileScope prof(_prof_switch);
     _SwitchEvaluate( );
-
-  if(!_route_vcs.empty()) {
-    _RouteUpdate( );
-    activity = activity || !_route_vcs.empty();
-  }
-  if(!_vc_alloc_vcs.empty()) {
-    _VCAllocUpdate( );
-    activity = activity || !_vc_alloc_vcs.empty();
   }
-  if(_hold_switch_for_packet) {
-    if(!_sw_hold_vcs.empty()) {
-      _SWHoldUpdate( );
-      activity = activity || !_sw_hold_vcs.empty();
+
+  {
+    ProfileScope prof(_prof_update);
+    if(!_route_vcs.empty()) {
+      _RouteUpdate( );
+      activity = activity || !_route_vcs.empty();
+    }
+    if(!_vc_alloc_vcs.empty()) {
+      _VCAllocUpdate( );
+      activity = activity || !_vc_alloc_vcs.empty();
+    }
+    if(_hold_switch_for_packet) {
+      if(!_sw_hold_vcs.empty()) {
+	_SWHoldUpdate( );
+	activity = activity || !_sw_hold_vcs.empty();
+      }
+    }
+    if(!_sw_alloc_vcs.empty()) {
+      _SWAllocUpdate( );
+      activity = activity || !_sw_alloc_vcs.empty();
+    }
+    if(!_crossbar_flits.empty()) {
+      _SwitchUpdate( );
+      activity = activity || !_crossbar_flits.empty();
     }
-  }
-  if(!_sw_alloc_vcs.empty()) {
-    _SWAllocUpdate( );
-    activity = activity || !_sw_alloc_vcs.empty();
-  }
-  if(!_crossbar_flits.empty()) {
-    _SwitchUpdate( );
-    activity = activity || !_crossbar_flits.empty();
   }
 
   _active = activity;
 
   _OutputQueuing( );
 
-  _bufferMonitor->cycle( );
-  _switchMonitor->cycle( );
 }
 
 void IQRouter::WriteOutputs( )
@@ -300,9 +335,7 @@ bool IQRouter::_ReceiveFlits( )
     Flit * const f = _input_channels[input]->Receive();
     if(f) {
 
-#ifdef TRACK_FLOWS
-      ++_received_flits[f->cl][input];
-#endif
+      ++_received_flits(f->cl, input);
 
       if(f->watch) {
 	*gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -369,12 +402,12 @@ void IQRouter::_InputQueuing( )
     }
     cur_buf->AddFlit(vc, f);
 
-#ifdef TRACK_FLOWS
-    ++_stored_flits[f->cl][input];
-    if(f->head) ++_active_packets[f->cl][input];
-#endif
+    ++_stored_flits(f->cl, input);
+    if(f->head) ++_active_packets(f->cl, input);
 
-    _bufferMonitor->write(input, f) ;
+    if(_bufferMonitor) {
+      _bufferMonitor->write(input, f) ;
+    }
 
     if(cur_buf->GetState(vc) == VC::idle) {
       assert(cur_buf->FrontFlit(vc) == f);
@@ -392,6 +425,9 @@ void IQRouter::_InputQueuing( )
 		     << " (front: " << f->id
 		     << ")." << endl;
 	}
+	if(gEventTrace) {
+	  gEventTrace->Record(EventTrace::ROUTE, f, _id, input, vc);
+	}
 	cur_buf->SetRouteSet(vc, &f->la_route_set);
 	cur_buf->SetState(vc, VC::vc_alloc);
 	if(_speculative) {
@@ -436,16 +472,16 @@ void IQRouter::_InputQueuing( )
     
     BufferState * const dest_buf = _next_buf[output];
     
-#ifdef TRACK_FLOWS
-    for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-      int const vc = *iter;
-      assert(!_outstanding_classes[output][vc].empty());
-      int cl = _outstanding_classes[output][vc].front();
-      _outstanding_classes[output][vc].pop();
-      assert(_outstanding_credits[cl][output] > 0);
-      --_outstanding_credits[cl][output];
+    if(_track_flows) {
+      for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+	int const vc = *iter;
+	assert(!_outstanding_classes[output][vc].empty());
+	int cl = _outstanding_classes[output][vc].front();
+	_outstanding_classes[output][vc].pop();
+	assert(_outstanding_credits.Get(cl, output) > 0);
+	--_outstanding_credits(cl, output);
+      }
     }
-#endif
 
     dest_buf->ProcessCredit(c);
     c->Free();
@@ -533,6 +569,9 @@ void IQRouter::_RouteUpdate( )
     }
 
     cur_buf->Route(vc, _rf, this, f, input);
+    if(gEventTrace) {
+      gEventTrace->Record(EventTrace::ROUTE, f, _id, input, vc);
+    }
     cur_buf->SetState(vc, VC::vc_alloc);
     if(_speculative) {
       _sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second, -1)));
@@ -896,6 +935,11 @@ void IQRouter::_VCAllocUpdate( )
       
       dest_buf->TakeBuffer(match_vc, input*_vcs + vc);
 	
+      if(gEventTrace) {
+	gEventTrace->Record(EventTrace::VC_GRANT, f, _id, input, vc, 
+			    match_output, match_vc);
+      }
+
       cur_buf->SetOutput(vc, match_output, match_vc);
       cur_buf->SetState(vc, VC::active);
       if(!_speculative) {
@@ -907,15 +951,13 @@ void IQRouter::_VCAllocUpdate( )
 		   << "  No output VC allocated." << endl;
       }
 
-#ifdef TRACK_STALLS
       assert((output_and_vc == STALL_BUFFER_BUSY) ||
 	     (output_and_vc == STALL_BUFFER_CONFLICT));
       if(output_and_vc == STALL_BUFFER_BUSY) {
-	++_buffer_busy_stalls[f->cl];
+	++_buffer_busy_stalls(f->cl);
       } else if(output_and_vc == STALL_BUFFER_CONFLICT) {
-	++_buffer_conflict_stalls[f->cl];
+	++_buffer_conflict_stalls(f->cl);
       }
-#endif
 
       _vc_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first, -1)));
     }
@@ -1067,14 +1109,19 @@ void IQRouter::_SWHoldUpdate( )
 		   << "." << endl;
       }
       
+      if(gEventTrace) {
+	gEventTrace->Record(EventTrace::SW_GRANT, f, _id, input, vc, 
+			    output, match_vc);
+      }
+
       cur_buf->RemoveFlit(vc);
 
-#ifdef TRACK_FLOWS
-      --_stored_flits[f->cl][input];
-      if(f->tail) --_active_packets[f->cl][input];
-#endif
+      --_stored_flits(f->cl, input);
+      if(f->tail) --_active_packets(f->cl, input);
 
-      _bufferMonitor->read(input, f) ;
+      if(_bufferMonitor) {
+	_bufferMonitor->read(input, f) ;
+      }
       
       f->hops++;
       f->vc = match_vc;
@@ -1114,10 +1161,10 @@ void IQRouter::_SWHoldUpdate( )
 	}
       }
 
-#ifdef TRACK_FLOWS
-      ++_outstanding_credits[f->cl][output];
-      _outstanding_classes[output][f->vc].push(f->cl);
-#endif
+      ++_outstanding_credits(f->cl, output);
+      if(_track_flows) {
+	_outstanding_classes[output][f->vc].push(f->cl);
+      }
 
       dest_buf->SendingFlit(f);
 
@@ -1957,6 +2004,11 @@ void IQRouter::_SWAllocUpdate( )
 	cur_buf->SetOutput(vc, output, match_vc);
 	dest_buf->TakeBuffer(match_vc, input*_vcs + vc);
 
+	if(gEventTrace) {
+	  gEventTrace->Record(EventTrace::VC_GRANT, f, _id, input, vc, 
+			      output, match_vc);
+	}
+
 	_vc_rr_offset[output*_classes+cl] = (match_vc + 1) % _vcs;
 
       } else {
@@ -1977,14 +2029,19 @@ void IQRouter::_SWAllocUpdate( )
 		   << "." << endl;
       }
 
+      if(gEventTrace) {
+	gEventTrace->Record(EventTrace::SW_GRANT, f, _id, input, vc, 
+			    output, match_vc);
+      }
+
       cur_buf->RemoveFlit(vc);
 
-#ifdef TRACK_FLOWS
-      --_stored_flits[f->cl][input];
-      if(f->tail) --_active_packets[f->cl][input];
-#endif
+      --_stored_flits(f->cl, input);
+      if(f->tail) --_active_packets(f->cl, input);
 
-      _bufferMonitor->read(input, f) ;
+      if(_bufferMonitor) {
+	_bufferMonitor->read(input, f) ;
+      }
 
       f->hops++;
       f->vc = match_vc;
@@ -2024,10 +2081,10 @@ void IQRouter::_SWAllocUpdate( )
 	}
       }
 
-#ifdef TRACK_FLOWS
-      ++_outstanding_credits[f->cl][output];
-      _outstanding_classes[output][f->vc].push(f->cl);
-#endif
+      ++_outstanding_credits(f->cl, output);
+      if(_track_flows) {
+	_outstanding_classes[output][f->vc].push(f->cl);
+      }
 
       dest_buf->SendingFlit(f);
 
@@ -2101,7 +2158,6 @@ void IQRouter::_SWAllocUpdate( )
 		   << "  No output port allocated." << endl;
       }
 
-#ifdef TRACK_STALLS
       assert((expanded_output == -1) || // for stalls that are accounted for in VC allocation path
 	     (expanded_output == STALL_BUFFER_BUSY) ||
 	     (expanded_output == STALL_BUFFER_CONFLICT) ||
@@ -2109,17 +2165,16 @@ void IQRouter::_SWAllocUpdate( )
 	     (expanded_output == STALL_BUFFER_RESERVED) ||
 	     (expanded_output == STALL_CROSSBAR_CONFLICT));
       if(expanded_output == STALL_BUFFER_BUSY) {
-	++_buffer_busy_stalls[f->cl];
+	++_buffer_busy_stalls(f->cl);
       } else if(expanded_output == STALL_BUFFER_CONFLICT) {
-	++_buffer_conflict_stalls[f->cl];
+	++_buffer_conflict_stalls(f->cl);
       } else if(expanded_output == STALL_BUFFER_FULL) {
-	++_buffer_full_stalls[f->cl];
+	++_buffer_full_stalls(f->cl);
       } else if(expanded_output == STALL_BUFFER_RESERVED) {
-	++_buffer_reserved_stalls[f->cl];
+	++_buffer_reserved_stalls(f->cl);
       } else if(expanded_output == STALL_CROSSBAR_CONFLICT) {
-	++_crossbar_conflict_stalls[f->cl];
+	++_crossbar_conflict_stalls(f->cl);
       }
-#endif
 
       _sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first, -1)));
     }
@@ -2193,7 +2248,9 @@ void IQRouter::_SwitchUpdate( )
 		 << "." << (expanded_output % _output_speedup)
 		 << "." << endl;
     }
-    _switchMonitor->traversal(input, output, f) ;
+    if(_switchMonitor) {
+      _switchMonitor->traversal(input, output, f) ;
+    }
 
     if(f->watch) {
       *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -2244,9 +2301,7 @@ void IQRouter::_SendFlits( )
       assert(f);
       _output_buffer[output].pop( );
 
-#ifdef TRACK_FLOWS
-      ++_sent_flits[f->cl][output];
-#endif
+      ++_sent_flits(f->cl, output);
 
       if(f->watch)
 	*gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -2297,7 +2352,6 @@ int IQRouter::GetBufferOccupancy(int i) const {
   return _buf[i]->GetOccupancy();
 }
 
-#ifdef TRACK_BUFFERS
 int IQRouter::GetUsedCreditForClass(int output, int cl) const
 {
   assert((output >= 0) && (output < _outputs));
@@ -2310,7 +2364,6 @@ int IQRouter::GetBufferOccupancyForClass(int input, int cl) const
   assert((input >= 0) && (input < _inputs));
   return _buf[input]->GetOccupancyForClass(cl);
 }
-#endif
 
 vector<int> IQRouter::UsedCredits() const
 {
@@ -63,6 +63,13 @@ class IQRouter : public Router {
   
   bool _active;
 
+  // self-profiler stage ids
+  int _prof_route;
+  int _prof_vc_alloc;
+  int _prof_sw_alloc;
+  int _prof_switch;
+  int _prof_update;
+
   int _routing_delay;
   int _vc_alloc_delay;
   int _sw_alloc_delay;
@@ -107,9 +114,9 @@ class IQRouter : public Router {
   vector<vector<int> > _noq_next_vc_start;
   vector<vector<int> > _noq_next_vc_end;
 
-#ifdef TRACK_FLOWS
+  // class of each outstanding credit per output VC (track_flows)
+  bool _track_flows;
   vector<vector<queue<int> > > _outstanding_classes;
-#endif
 
   bool _ReceiveFlits( );
   bool _ReceiveCredits( );
@@ -166,17 +173,17 @@ public:
   virtual int GetUsedCredit(int o) const;
   virtual int GetBufferOccupancy(int i) const;
 
-#ifdef TRACK_BUFFERS
   virtual int GetUsedCreditForClass(int output, int cl) const;
   virtual int GetBufferOccupancyForClass(int input, int cl) const;
-#endif
 
   virtual vector<int> UsedCredits() const;
   virtual vector<int> FreeCredits() const;
   virtual vector<int> MaxCredits() const;
 
-  SwitchMonitor const * const GetSwitchMonitor() const {return _switchMonitor;}
-  BufferMonitor const * const GetBufferMonitor() const {return _bufferMonitor;}
+  virtual SwitchMonitor const * GetSwitchMonitor() const {return _switchMonitor;}
+  virtual BufferMonitor const * GetBufferMonitor() const {return _bufferMonitor;}
+  virtual int NumActivityCounters() const;
+  virtual void BindActivityCounters(int * counters);
 
 };
 
@@ -42,6 +42,7 @@
 #include <iostream>
 #include <cassert>
 #include "router.hpp"
+#include "profiler.hpp"
 
 //////////////////Sub router types//////////////////////
 #include "iq_router.hpp"
@@ -69,21 +70,23 @@ TimedModule( parent, name ), _id( id ), _inputs( inputs ), _outputs( outputs ),
   _internal_speedup = config.GetFloat( "internal_speedup" );
   _classes          = config.GetInt( "classes" );
 
-#ifdef TRACK_FLOWS
-  _received_flits.resize(_classes, vector<int>(_inputs, 0));
-  _stored_flits.resize(_classes);
-  _sent_flits.resize(_classes, vector<int>(_outputs, 0));
-  _active_packets.resize(_classes);
-  _outstanding_credits.resize(_classes, vector<int>(_outputs, 0));
-#endif
-
-#ifdef TRACK_STALLS
-  _buffer_busy_stalls.resize(_classes, 0);
-  _buffer_conflict_stalls.resize(_classes, 0);
-  _buffer_full_stalls.resize(_classes, 0);
-  _buffer_reserved_stalls.resize(_classes, 0);
-  _crossbar_conflict_stalls.resize(_classes, 0);
-#endif
+  _prof_evaluate = Profiler::Register( "evaluate/" + config.GetStr( "router" ) );
+
+  _random_state = RandomStreamSeed( id );
+
+  bool const track_flows = (config.GetInt( "track_flows" ) > 0);
+  _received_flits.Init(track_flows, _classes, _inputs);
+  _stored_flits.Init(track_flows, _classes, _inputs);
+  _sent_flits.Init(track_flows, _classes, _outputs);
+  _active_packets.Init(track_flows, _classes, _inputs);
+  _outstanding_credits.Init(track_flows, _classes, _outputs);
+
+  bool const track_stalls = (config.GetInt( "track_stalls" ) > 0);
+  _buffer_busy_stalls.Init(track_stalls, _classes);
+  _buffer_conflict_stalls.Init(track_stalls, _classes);
+  _buffer_full_stalls.Init(track_stalls, _classes);
+  _buffer_reserved_stalls.Init(track_stalls, _classes);
+  _crossbar_conflict_stalls.Init(track_stalls, _classes);
 
 }
 
@@ -104,6 +107,7 @@ void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel
 
 void Router::Evaluate( )
 {
+  ProfileScope prof(_prof_evaluate);
   _partial_internal_cycles += _internal_speedup;
   while( _partial_internal_cycles >= 1.0 ) {
     _InternalStep( );
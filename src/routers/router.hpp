@@ -37,9 +37,14 @@
 #include "flitchannel.hpp"
 #include "channel.hpp"
 #include "config_utils.hpp"
+#include "class_counters.hpp"
+#include "random_utils.hpp"
 
 typedef Channel<Credit> CreditChannel;
 
+class BufferMonitor;
+class SwitchMonitor;
+
 class Router : public TimedModule {
 
 protected:
@@ -63,6 +68,12 @@ protected:
   double _internal_speedup;
   double _partial_internal_cycles;
 
+  // self-profiler stage for this router type
+  int _prof_evaluate;
+
+  // state of the router's own random stream (see gRandomStream)
+  mutable unsigned long long _random_state;
+
   int _crossbar_delay;
   int _credit_delay;
   
@@ -72,21 +83,19 @@ protected:
   vector<CreditChannel *> _output_credits;
   vector<bool>            _channel_faults;
 
-#ifdef TRACK_FLOWS
-  vector<vector<int> > _received_flits;
-  vector<vector<int> > _stored_flits;
-  vector<vector<int> > _sent_flits;
-  vector<vector<int> > _outstanding_credits;
-  vector<vector<int> > _active_packets;
-#endif
+  // flow counters, indexed by class and port (track_flows)
+  ClassCounters _received_flits;
+  ClassCounters _stored_flits;
+  ClassCounters _sent_flits;
+  ClassCounters _outstanding_credits;
+  ClassCounters _active_packets;
 
-#ifdef TRACK_STALLS
-  vector<int> _buffer_busy_stalls;
-  vector<int> _buffer_conflict_stalls;
-  vector<int> _buffer_full_stalls;
-  vector<int> _buffer_reserved_stalls;
-  vector<int> _crossbar_conflict_stalls;
-#endif
+  // stall counters, indexed by class (track_stalls)
+  ClassCounters _buffer_busy_stalls;
+  ClassCounters _buffer_conflict_stalls;
+  ClassCounters _buffer_full_stalls;
+  ClassCounters _buffer_reserved_stalls;
+  ClassCounters _crossbar_conflict_stalls;
 
   virtual void _InternalStep() = 0;
 
@@ -120,80 +129,76 @@ public:
 
   inline int GetID( ) const {return _id;}
 
+  inline void SeedRandom( unsigned long long seed ) {
+    _random_state = RandomStreamSeed( seed );
+  }
+  inline unsigned long long * RandomStream( ) const {return &_random_state;}
+
 
   virtual int GetUsedCredit(int o) const = 0;
   virtual int GetBufferOccupancy(int i) const = 0;
 
-#ifdef TRACK_BUFFERS
   virtual int GetUsedCreditForClass(int output, int cl) const = 0;
   virtual int GetBufferOccupancyForClass(int input, int cl) const = 0;
-#endif
 
-#ifdef TRACK_FLOWS
-  inline vector<int> const & GetReceivedFlits(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _received_flits[c];
+  inline vector<int> GetReceivedFlits(int c) const {
+    return _received_flits.Row(c);
   }
-  inline vector<int> const & GetStoredFlits(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _stored_flits[c];
+  inline vector<int> GetStoredFlits(int c) const {
+    return _stored_flits.Row(c);
   }
-  inline vector<int> const & GetSentFlits(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _sent_flits[c];
+  inline vector<int> GetSentFlits(int c) const {
+    return _sent_flits.Row(c);
   }
-  inline vector<int> const & GetOutstandingCredits(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _outstanding_credits[c];
+  inline vector<int> GetOutstandingCredits(int c) const {
+    return _outstanding_credits.Row(c);
   }
 
-  inline vector<int> const & GetActivePackets(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _active_packets[c];
+  inline vector<int> GetActivePackets(int c) const {
+    return _active_packets.Row(c);
   }
 
   inline void ResetFlowStats(int c) {
-    assert((c >= 0) && (c < _classes));
-    _received_flits[c].assign(_received_flits[c].size(), 0);
-    _sent_flits[c].assign(_sent_flits[c].size(), 0);
+    _received_flits.Reset(c);
+    _sent_flits.Reset(c);
   }
-#endif
 
   virtual vector<int> UsedCredits() const = 0;
   virtual vector<int> FreeCredits() const = 0;
   virtual vector<int> MaxCredits() const = 0;
 
-#ifdef TRACK_STALLS
+  // activity monitors used by the power model; NULL for router types that 
+  // do not maintain them
+  virtual SwitchMonitor const * GetSwitchMonitor() const {return NULL;}
+  virtual BufferMonitor const * GetBufferMonitor() const {return NULL;}
+  // number of activity counters the monitors need, and attaching them to 
+  // a slice of the network's activity array
+  virtual int NumActivityCounters() const {return 0;}
+  virtual void BindActivityCounters(int * counters) {}
+
   inline int GetBufferBusyStalls(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _buffer_busy_stalls[c];
+    return _buffer_busy_stalls.Get(c);
   }
   inline int GetBufferConflictStalls(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _buffer_conflict_stalls[c];
+    return _buffer_conflict_stalls.Get(c);
   }
   inline int GetBufferFullStalls(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _buffer_full_stalls[c];
+    return _buffer_full_stalls.Get(c);
   }
   inline int GetBufferReservedStalls(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _buffer_reserved_stalls[c];
+    return _buffer_reserved_stalls.Get(c);
   }
   inline int GetCrossbarConflictStalls(int c) const {
-    assert((c >= 0) && (c < _classes));
-    return _crossbar_conflict_stalls[c];
+    return _crossbar_conflict_stalls.Get(c);
   }
 
   inline void ResetStallStats(int c) {
-    assert((c >= 0) && (c < _classes));
-    _buffer_busy_stalls[c] = 0;
-    _buffer_conflict_stalls[c] = 0;
-    _buffer_full_stalls[c] = 0;
-    _buffer_reserved_stalls[c] = 0;
-    _crossbar_conflict_stalls[c] = 0;
+    _buffer_busy_stalls.Reset(c);
+    _buffer_conflict_stalls.Reset(c);
+    _buffer_full_stalls.Reset(c);
+    _buffer_reserved_stalls.Reset(c);
+    _crossbar_conflict_stalls.Reset(c);
   }
-#endif
 
   inline int NumInputs() const {return _inputs;}
   inline int NumOutputs() const {return _outputs;}
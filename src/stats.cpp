@@ -56,6 +56,7 @@ void Stats::Clear( )
   _sample_squared_sum = 0.0;
 
   _hist.assign(_num_bins, 0);
+  _quantile_hist.clear();
 
   _min = numeric_limits<double>::quiet_NaN();
   _max = -numeric_limits<double>::quiet_NaN();
@@ -102,6 +103,7 @@ void Stats::AddSample( double val )
 {
   ++_num_samples;
   _sample_sum += val;
+  _sample_squared_sum += val * val;
 
   // NOTE: the negation ensures that NaN values are handled correctly!
   _max = !(val <= _max) ? val : _max;
@@ -112,6 +114,82 @@ void Stats::AddSample( double val )
   b = (b >= _num_bins) ? (_num_bins - 1) : b;
 
   _hist[b]++;
+
+  int const q = _QuantileBucket(val);
+  if(q >= (int)_quantile_hist.size()) {
+    _quantile_hist.resize(q + 1, 0);
+  }
+  _quantile_hist[q]++;
+}
+
+int Stats::_QuantileBucket( double val )
+{
+  double const v = floor(val);
+  if(!(v >= 0.0)) {
+    return 0;
+  }
+  int const sub = 1 << QUANTILE_BITS;
+  if(v < (double)sub) {
+    return (int)v;
+  }
+  // v lies in [2^(e-1), 2^e); keep its QUANTILE_BITS most significant bits
+  int e;
+  frexp(v, &e);
+  int const shift = e - QUANTILE_BITS;
+  int const mantissa = (int)ldexp(v, -shift);
+  return shift * (sub >> 1) + mantissa;
+}
+
+double Stats::_QuantileBucketMax( int b )
+{
+  int const sub = 1 << QUANTILE_BITS;
+  if(b < sub) {
+    return (double)b;
+  }
+  int const shift = b / (sub >> 1) - 1;
+  int const mantissa = b - shift * (sub >> 1);
+  return ldexp((double)(mantissa + 1), shift) - 1.0;
+}
+
+// Returns the smallest bucket bound below which at least a fraction q of 
+// the samples lie, clamped to the observed range.
+double Stats::Quantile( double q ) const
+{
+  if(_num_samples == 0) {
+    return numeric_limits<double>::quiet_NaN();
+  }
+  double const rank = fmax(ceil(q * (double)_num_samples), 1.0);
+  double count = 0.0;
+  for(size_t b = 0; b < _quantile_hist.size(); ++b) {
+    count += (double)_quantile_hist[b];
+    if(count >= rank) {
+      return fmax(fmin(_QuantileBucketMax(b), _max), _min);
+    }
+  }
+  return _max;
+}
+
+void Stats::Merge( Stats const & s )
+{
+  if(s._num_samples == 0) {
+    return;
+  }
+  _num_samples += s._num_samples;
+  _sample_sum += s._sample_sum;
+  _sample_squared_sum += s._sample_squared_sum;
+  _max = !(s._max <= _max) ? s._max : _max;
+  _min = !(s._min >= _min) ? s._min : _min;
+  if((s._num_bins == _num_bins) && (s._bin_size == _bin_size)) {
+    for(int b = 0; b < _num_bins; ++b) {
+      _hist[b] += s._hist[b];
+    }
+  }
+  if(s._quantile_hist.size() > _quantile_hist.size()) {
+    _quantile_hist.resize(s._quantile_hist.size(), 0);
+  }
+  for(size_t b = 0; b < s._quantile_hist.size(); ++b) {
+    _quantile_hist[b] += s._quantile_hist[b];
+  }
 }
 
 void Stats::Display( ostream & os ) const
@@ -44,6 +44,15 @@ class Stats : public Module {
 
   vector<int> _hist;
 
+  // log-linear histogram of all samples for quantile estimates: values 
+  // below 2^QUANTILE_BITS are counted exactly, larger ones in buckets 
+  // whose width is at most 2^-(QUANTILE_BITS-1) of their value
+  static int const QUANTILE_BITS = 7;
+  vector<unsigned int> _quantile_hist;
+
+  static int _QuantileBucket( double val );
+  static double _QuantileBucketMax( int b );
+
 public:
   Stats( Module *parent, const string &name,
 	 double bin_size = 1.0, int num_bins = 10 );
@@ -57,6 +66,9 @@ public:
   double Sum( ) const;
   double SquaredSum( ) const;
   int    NumSamples( ) const;
+  double Quantile( double q ) const;
+
+  void Merge( Stats const & s );
 
   void AddSample( double val );
   inline void AddSample( int val ) {
@@ -0,0 +1,184 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sstream>
+
+#include "packet_reply_info.hpp"
+#include "tracetrafficmanager.hpp"
+
+TraceTrafficManager::TraceTrafficManager( const Configuration &config, 
+					  const vector<Network *> & net )
+  : TrafficManager(config, net), _pending_count(0)
+{
+  string const trace_file = config.GetStr( "trace_file" );
+  if(trace_file == "") {
+    Error( "Trace simulation requires a trace_file." );
+  }
+
+  _time_scale = config.GetFloat( "trace_time_scale" );
+  if(_time_scale <= 0.0) {
+    Error( "trace_time_scale must be positive." );
+  }
+  _passes = config.GetInt( "trace_loop" );
+  if(_passes < 0) {
+    Error( "trace_loop must not be negative." );
+  }
+
+  _reader = new TraceReader( trace_file, _passes );
+  if(_reader->NumNodes() > _nodes) {
+    ostringstream err;
+    err << "Trace was generated for " << _reader->NumNodes() 
+	<< " nodes, but the network only has " << _nodes << ".";
+    Error( err.str() );
+  }
+
+  _pending.resize(_nodes);
+}
+
+TraceTrafficManager::~TraceTrafficManager( )
+{
+  delete _reader;
+}
+
+void TraceTrafficManager::_RetireFlit( Flit *f, int dest )
+{
+  if(f->tail) {
+    map<int, long long>::iterator iter = _packet_record.find(f->pid);
+    if(iter != _packet_record.end()) {
+      _undelivered.erase(iter->second);
+      _packet_record.erase(iter);
+    }
+  }
+  bool const request = 
+    f->tail && ((f->type == Flit::READ_REQUEST) || (f->type == Flit::WRITE_REQUEST));
+  TrafficManager::_RetireFlit(f, dest);
+  // replies are part of the trace itself, so drop the one queued by the base 
+  // class for this request
+  if(request) {
+    _repliesPending[dest].back()->Free();
+    _repliesPending[dest].pop_back();
+  }
+}
+
+void TraceTrafficManager::_Inject( )
+{
+  // move every record that has become due into its source queue
+  TraceRecord const * r;
+  while((r = _reader->Front()) && 
+	((double)r->time * _time_scale <= (double)_time)) {
+    if((r->src < 0) || (r->src >= _nodes) || (r->dest < 0) || 
+       (r->dest >= _nodes) || (r->size <= 0) || (r->cl < 0) || 
+       (r->cl >= _classes) || (r->type < 0) || (r->type >= Flit::NUM_FLIT_TYPES)) {
+      ostringstream err;
+      err << "Invalid trace record " << r->index << ".";
+      Error( err.str() );
+    }
+    _undelivered.insert(r->index);
+    _pending[r->src].push_back(*r);
+    ++_pending_count;
+    _reader->Pop();
+  }
+
+  if(_pending_count == 0) {
+    return;
+  }
+
+  // inject queued records in order, stalling a source while the record at 
+  // its head is still waiting for its dependency to be received
+  for(int source = 0; source < _nodes; ++source) {
+    deque<TraceRecord> & pending = _pending[source];
+    while(!pending.empty()) {
+      TraceRecord const & p = pending.front();
+      if((p.dep >= 0) && (_undelivered.count(p.dep) > 0)) {
+	break;
+      }
+      int const pid = _EnqueuePacket(source, p.dest, p.size, p.cl, _time, 
+				     (Flit::FlitType)p.type, false);
+      _packet_record.insert(make_pair(pid, p.index));
+      pending.pop_front();
+      --_pending_count;
+    }
+  }
+}
+
+bool TraceTrafficManager::_SingleSim( )
+{
+  _sim_state = running;
+  int const start_time = _time;
+  int const max_time = (_passes > 0) ? -1 : (_max_samples * _sample_period);
+
+  cout << "Replaying trace (" << _reader->NumRecords() << " records";
+  if(_passes != 1) {
+    cout << ", ";
+    if(_passes > 0) {
+      cout << _passes << " passes";
+    } else {
+      cout << "looping for " << max_time << " cycles";
+    }
+  }
+  cout << ")..." << endl;
+
+  bool trace_done = false;
+  while(!trace_done) {
+    for(int iter = 0; iter < _sample_period; ++iter) {
+      trace_done = ((max_time >= 0) && (_time - start_time >= max_time)) ||
+	((_pending_count == 0) && !_reader->Front());
+      if(trace_done) {
+	break;
+      }
+      _Step();
+    }
+    UpdateStats();
+    DisplayStats();
+  }
+  cout << "Trace injected. Time used is " << _time - start_time << " cycles." << endl;
+
+  // stop injecting and wait for every packet of the trace to be received
+  _empty_network = true;
+  bool packets_left = true;
+  int empty_steps = 0;
+  while(packets_left) {
+    packets_left = false;
+    for(int c = 0; c < _classes; ++c) {
+      packets_left |= !_total_in_flight_flits[c].empty();
+    }
+    if(packets_left) {
+      _Step();
+      ++empty_steps;
+      if(empty_steps % 1000 == 0) {
+	_DisplayRemaining();
+      }
+    }
+  }
+  _empty_network = false;
+  cout << "Trace received. Time used is " << _time - start_time << " cycles." << endl;
+
+  _sim_state = draining;
+  _drain_time = _time;
+
+  return true;
+}
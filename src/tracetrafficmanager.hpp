@@ -0,0 +1,69 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _TRACETRAFFICMANAGER_HPP_
+#define _TRACETRAFFICMANAGER_HPP_
+
+#include <iostream>
+#include <deque>
+#include <map>
+#include <set>
+
+#include "config_utils.hpp"
+#include "packet_trace.hpp"
+#include "trafficmanager.hpp"
+
+class TraceTrafficManager : public TrafficManager {
+
+protected:
+
+  TraceReader * _reader;
+
+  double _time_scale;
+  int _passes;
+
+  long long _pending_count;
+  vector<deque<TraceRecord> > _pending;
+
+  // trace records that have been read but whose packets have not yet been 
+  // received, and the packets that carry them
+  set<long long> _undelivered;
+  map<int, long long> _packet_record;
+
+  virtual void _RetireFlit( Flit *f, int dest );
+
+  virtual void _Inject( );
+  virtual bool _SingleSim( );
+
+public:
+
+  TraceTrafficManager( const Configuration &config, const vector<Network *> & net );
+  virtual ~TraceTrafficManager( );
+
+};
+
+#endif
@@ -27,6 +27,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <fstream>
 #include <ctime>
 #include "random_utils.hpp"
 #include "traffic.hpp"
@@ -45,6 +46,11 @@ void TrafficPattern::reset()
 
 }
 
+vector<double> TrafficPattern::source_weights() const
+{
+  return vector<double>();
+}
+
 TrafficPattern * TrafficPattern::New(string const & pattern, int nodes, 
 				     Configuration const * const config)
 {
@@ -191,6 +197,12 @@ TrafficPattern * TrafficPattern::New(string const & pattern, int nodes,
       rates.resize(hotspots.size(), 1);
     }
     result = new HotSpotTrafficPattern(nodes, hotspots, rates);
+  } else if(pattern_name == "matrix") {
+    if(params.empty()) {
+      cout << "Error: Missing file name for matrix traffic pattern: " << pattern << endl;
+      exit(-1);
+    }
+    result = new MatrixTrafficPattern(nodes, params[0]);
   } else {
     cout << "Error: Unknown traffic pattern: " << pattern << endl;
     exit(-1);
@@ -524,3 +536,175 @@ int HotSpotTrafficPattern::dest(int source)
   assert(_rates.back() > pct);
   return _hotspots.back();
 }
+
+MatrixTrafficPattern::MatrixTrafficPattern(int nodes, string const & filename)
+  : TrafficPattern(nodes)
+{
+  vector<vector<pair<int, double> > > rows(nodes);
+  _ReadFile(filename, rows);
+
+  _offset.resize(nodes + 1, 0);
+  _row_sum.resize(nodes, 0.0);
+
+  // build one alias table per source row (Vose's variant of Walker's method)
+  vector<int> small;
+  vector<int> large;
+  vector<double> scaled;
+  for(int s = 0; s < nodes; ++s) {
+    vector<pair<int, double> > const & row = rows[s];
+    int const base = _dest.size();
+    int const size = row.size();
+    _offset[s] = base;
+    _offset[s+1] = base + size;
+    double sum = 0.0;
+    for(int i = 0; i < size; ++i) {
+      sum += row[i].second;
+    }
+    _row_sum[s] = sum;
+    if(size == 0) {
+      continue;
+    }
+    _dest.resize(base + size);
+    _alias.resize(base + size);
+    _prob.resize(base + size);
+    scaled.resize(size);
+    small.clear();
+    large.clear();
+    for(int i = 0; i < size; ++i) {
+      _dest[base+i] = row[i].first;
+      scaled[i] = row[i].second * (double)size / sum;
+      if(scaled[i] < 1.0) {
+	small.push_back(i);
+      } else {
+	large.push_back(i);
+      }
+    }
+    while(!small.empty() && !large.empty()) {
+      int const l = small.back();
+      small.pop_back();
+      int const g = large.back();
+      _prob[base+l] = scaled[l];
+      _alias[base+l] = row[g].first;
+      scaled[g] = (scaled[g] + scaled[l]) - 1.0;
+      if(scaled[g] < 1.0) {
+	large.pop_back();
+	small.push_back(g);
+      }
+    }
+    // whatever is left over only differs from 1.0 due to rounding
+    for(size_t i = 0; i < large.size(); ++i) {
+      _prob[base+large[i]] = 1.0;
+      _alias[base+large[i]] = row[large[i]].first;
+    }
+    for(size_t i = 0; i < small.size(); ++i) {
+      _prob[base+small[i]] = 1.0;
+      _alias[base+small[i]] = row[small[i]].first;
+    }
+  }
+}
+
+// The matrix file either holds one row of _nodes rates per source (dense), 
+// or one "source destination rate" triple per line (sparse); blank lines and 
+// lines starting with '#' or '//' are ignored.
+void MatrixTrafficPattern::_ReadFile(string const & filename,
+				     vector<vector<pair<int, double> > > & rows)
+{
+  ifstream in(filename.c_str());
+  if(!in) {
+    cout << "Error: Unable to open traffic matrix file: " << filename << endl;
+    exit(-1);
+  }
+  int dense_row = 0;
+  bool sparse = false;
+  bool first = true;
+  string line;
+  int lineno = 0;
+  while(getline(in, line)) {
+    ++lineno;
+    size_t start = line.find_first_not_of(" \t\r");
+    if((start == string::npos) || (line[start] == '#') || 
+       (line.compare(start, 2, "//") == 0)) {
+      continue;
+    }
+    istringstream iss(line);
+    vector<double> values;
+    double v;
+    while(iss >> v) {
+      values.push_back(v);
+    }
+    if(first) {
+      sparse = ((int)values.size() != _nodes) && (values.size() == 3);
+      first = false;
+    }
+    if(sparse) {
+      if(values.size() != 3) {
+	cout << "Error: Expected \"source destination rate\" in traffic matrix file "
+	     << filename << " on line " << lineno << "." << endl;
+	exit(-1);
+      }
+      int const s = (int)values[0];
+      int const d = (int)values[1];
+      if((s < 0) || (s >= _nodes) || (d < 0) || (d >= _nodes) || (values[2] < 0.0)) {
+	cout << "Error: Invalid entry in traffic matrix file " << filename
+	     << " on line " << lineno << "." << endl;
+	exit(-1);
+      }
+      if(values[2] > 0.0) {
+	rows[s].push_back(make_pair(d, values[2]));
+      }
+    } else {
+      if(((int)values.size() != _nodes) || (dense_row >= _nodes)) {
+	cout << "Error: Traffic matrix file " << filename << " must contain "
+	     << _nodes << " rows of " << _nodes << " rates (line " << lineno 
+	     << ")." << endl;
+	exit(-1);
+      }
+      for(int d = 0; d < _nodes; ++d) {
+	if(values[d] < 0.0) {
+	  cout << "Error: Negative rate in traffic matrix file " << filename
+	       << " on line " << lineno << "." << endl;
+	  exit(-1);
+	}
+	if(values[d] > 0.0) {
+	  rows[dense_row].push_back(make_pair(d, values[d]));
+	}
+      }
+      ++dense_row;
+    }
+  }
+  if(!sparse && (dense_row != _nodes)) {
+    cout << "Error: Traffic matrix file " << filename << " must contain "
+	 << _nodes << " rows of " << _nodes << " rates." << endl;
+    exit(-1);
+  }
+}
+
+int MatrixTrafficPattern::dest(int source)
+{
+  assert((source >= 0) && (source < _nodes));
+  int const base = _offset[source];
+  int const size = _offset[source+1] - base;
+  // sources with an empty row have zero weight and are never asked for a 
+  // destination unless the injection process ignores source weights
+  assert(size > 0);
+  int const i = base + RandomInt(size - 1);
+  return (RandomFloat() < _prob[i]) ? _dest[i] : _alias[i];
+}
+
+vector<double> MatrixTrafficPattern::source_weights() const
+{
+  // normalize row sums so the average source injects at the configured rate
+  double total = 0.0;
+  for(int s = 0; s < _nodes; ++s) {
+    total += _row_sum[s];
+  }
+  if(total <= 0.0) {
+    cout << "Error: Traffic matrix does not contain any non-zero rates." << endl;
+    exit(-1);
+  }
+  vector<double> weights(_nodes);
+  for(int s = 0; s < _nodes; ++s) {
+    weights[s] = _row_sum[s] * (double)_nodes / total;
+  }
+  return weights;
+}
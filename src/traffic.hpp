@@ -42,6 +42,7 @@ public:
   virtual ~TrafficPattern() {}
   virtual void reset();
   virtual int dest(int source) = 0;
+  virtual vector<double> source_weights() const;
   static TrafficPattern * New(string const & pattern, int nodes, 
 			      Configuration const * const config = NULL);
 };
@@ -171,4 +172,20 @@ public:
   virtual int dest(int source);
 };
 
+class MatrixTrafficPattern : public TrafficPattern {
+private:
+  // per-source Walker alias tables, stored back to back; source s owns
+  // entries [_offset[s], _offset[s+1])
+  vector<int> _offset;
+  vector<int> _dest;
+  vector<int> _alias;
+  vector<double> _prob;
+  vector<double> _row_sum;
+  void _ReadFile(string const & filename, vector<vector<pair<int, double> > > & rows);
+public:
+  MatrixTrafficPattern(int nodes, string const & filename);
+  virtual int dest(int source);
+  virtual vector<double> source_weights() const;
+};
+
 #endif
@@ -29,6 +29,7 @@
 #include <cmath>
 #include <fstream>
 #include <limits>
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 
@@ -36,9 +37,15 @@
 #include "booksim_config.hpp"
 #include "trafficmanager.hpp"
 #include "batchtrafficmanager.hpp"
+#include "tracetrafficmanager.hpp"
+#include "collectivetrafficmanager.hpp"
 #include "random_utils.hpp" 
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
+#include "misc_utils.hpp"
+#include "profiler.hpp"
+#include "event_trace.hpp"
+#include "parallel_engine.hpp"
 
 TrafficManager * TrafficManager::New(Configuration const & config,
                                      vector<Network *> const & net)
@@ -49,6 +56,10 @@ TrafficManager * TrafficManager::New(Configuration const & config,
         result = new TrafficManager(config, net);
     } else if(sim_type == "batch") {
         result = new BatchTrafficManager(config, net);
+    } else if(sim_type == "trace") {
+        result = new TraceTrafficManager(config, net);
+    } else if(sim_type == "collective") {
+        result = new CollectiveTrafficManager(config, net);
     } else {
         cerr << "Unknown simulation type: " << sim_type << endl;
     } 
@@ -230,6 +241,10 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     for(int c = 0; c < _classes; ++c) {
         _traffic_pattern[c] = TrafficPattern::New(_traffic[c], _nodes, &config);
         _injection_process[c] = InjectionProcess::New(injection_process[c], _nodes, _load[c], &config);
+        vector<double> const weights = _traffic_pattern[c]->source_weights();
+        if(!weights.empty()) {
+            _injection_process[c]->set_source_weights(weights);
+        }
     }
 
     // ============ Injection VC states  ============ 
@@ -256,16 +271,20 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         }
     }
 
-#ifdef TRACK_FLOWS
-    _outstanding_credits.resize(_classes);
-    for(int c = 0; c < _classes; ++c) {
-        _outstanding_credits[c].resize(_subnets, vector<int>(_nodes, 0));
-    }
-    _outstanding_classes.resize(_nodes);
-    for(int n = 0; n < _nodes; ++n) {
-        _outstanding_classes[n].resize(_subnets, vector<queue<int> >(_vcs));
+    _track_flows = (config.GetInt("track_flows") > 0);
+    _track_stalls = (config.GetInt("track_stalls") > 0);
+    _track_credits = (config.GetInt("track_credits") > 0);
+
+    if(_track_flows) {
+        _outstanding_credits.resize(_classes);
+        for(int c = 0; c < _classes; ++c) {
+            _outstanding_credits[c].resize(_subnets, vector<int>(_nodes, 0));
+        }
+        _outstanding_classes.resize(_nodes);
+        for(int n = 0; n < _nodes; ++n) {
+            _outstanding_classes[n].resize(_subnets, vector<queue<int> >(_vcs));
+        }
     }
-#endif
 
     // ============ Injection queues ============ 
 
@@ -282,6 +301,7 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _total_in_flight_flits.resize(_classes);
     _measured_in_flight_flits.resize(_classes);
     _retired_packets.resize(_classes);
+    _ejected.resize(_subnets, vector<Flit *>(_nodes, NULL));
 
     _packet_seq_no.resize(_nodes);
     _repliesPending.resize(_nodes);
@@ -307,6 +327,18 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
       seed = config.GetInt("seed");
     }
     RandomSeed(seed);
+    _random_streams = ((config.GetInt("random_streams") > 0) ||
+                       (config.GetInt("parallel_regions") > 0));
+    if(_random_streams) {
+        for (int i=0; i < _subnets; ++i) {
+            _net[i]->SeedRandomStreams((unsigned long long)seed * _subnets + i);
+        }
+        // the terminals' streams are derived from seeds the routers' never use
+        _node_random.resize(_nodes);
+        for (int n=0; n < _nodes; ++n) {
+            _node_random[n] = RandomStreamSeed(~((unsigned long long)seed * _nodes + n));
+        }
+    }
 
     _measure_latency = (config.GetStr("sim_type") == "latency");
 
@@ -319,7 +351,8 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _measure_stats.push_back(config.GetInt("measure_stats"));
     }
     _measure_stats.resize(_classes, _measure_stats.back());
-    _pair_stats = (config.GetInt("pair_stats")==1);
+    _pair_stats = (config.GetInt("pair_stats") > 0);
+    _sparse_pair_stats = (config.GetInt("pair_stats") == 2);
 
     _latency_thres = config.GetFloatArray( "latency_thres" );
     if(_latency_thres.empty()) {
@@ -351,6 +384,40 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     }
     _acc_stopping_threshold.resize(_classes, _acc_stopping_threshold.back());
 
+    string stopping_rule = config.GetStr( "stopping_rule" );
+    if(stopping_rule == "change") {
+        _ci_stopping = false;
+    } else if(stopping_rule == "ci") {
+        _ci_stopping = true;
+    } else {
+        Error( "Unknown stopping rule: " + stopping_rule );
+    }
+    _ci_precision = config.GetFloat( "ci_precision" );
+    _ci_confidence = config.GetFloat( "ci_confidence" );
+    if((_ci_confidence <= 0.0) || (_ci_confidence >= 1.0)) {
+        Error( "ci_confidence must be between 0 and 1." );
+    }
+    // student_t_quantile is only accurate for three or more degrees of freedom
+    _ci_min_batches = max(config.GetInt( "ci_min_batches" ), 4);
+
+    string warmup_rule = config.GetStr( "warmup_rule" );
+    if(warmup_rule == "change") {
+        _mser_warmup = false;
+    } else if(warmup_rule == "mser") {
+        _mser_warmup = true;
+    } else {
+        Error( "Unknown warmup rule: " + warmup_rule );
+    }
+    _mser_window = config.GetInt( "mser_window" );
+    if(_mser_window <= 0) {
+        Error( "mser_window must be positive." );
+    }
+    // the rule needs at least five batches to evaluate any truncation point
+    _mser_min_batches = max(config.GetInt( "mser_min_batches" ), 5);
+
+    _saturation_threshold = config.GetFloat( "saturation_thres" );
+    _saturation_periods = max(config.GetInt( "saturation_periods" ), 1);
+
     _include_queuing = config.GetInt( "include_queuing" );
 
     _print_csv_results = config.GetInt( "print_csv_results" );
@@ -380,10 +447,110 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _stats_out = new ofstream(stats_out_file.c_str());
         config.WriteMatlabFile(_stats_out);
     }
+
+    _prof_eject = Profiler::Register("eject");
+    _prof_read_inputs = Profiler::Register("read_inputs");
+    _prof_inject = Profiler::Register("inject");
+    _prof_inject_flits = Profiler::Register("inject_flits");
+    _prof_retire = Profiler::Register("retire");
+    _prof_evaluate = Profiler::Register("evaluate");
+    _prof_write_outputs = Profiler::Register("write_outputs");
+    _prof_flits = 0;
+
+    string trace_out_file = config.GetStr( "trace_out" );
+    _trace_out = NULL;
+    if(trace_out_file != "") {
+        _trace_out = new TraceWriter(trace_out_file, _nodes);
+    }
+
+    string util_sample_file = config.GetStr( "util_sample_out" );
+    _util_sampler = NULL;
+    _util_sample_period = config.GetInt( "util_sample_period" );
+    if(util_sample_file != "") {
+        if(_util_sample_period <= 0) {
+            Error( "util_sample_period must be positive." );
+        }
+        string const format = config.GetStr( "util_sample_format" );
+        if((format != "csv") && (format != "binary")) {
+            Error( "Unknown util_sample_format: " + format );
+        }
+        _util_sampler = new ChannelSampler(util_sample_file, _net, 
+                                           format == "binary");
+    }
+
+    string power_epoch_file = config.GetStr( "power_epoch_out" );
+    _power_epoch_out = NULL;
+    _power_epoch_period = config.GetInt( "power_epoch_period" );
+    if(power_epoch_file != "") {
+        if(_power_epoch_period <= 0) {
+            Error( "power_epoch_period must be positive." );
+        }
+        _power_epoch_out = new ofstream(power_epoch_file.c_str());
+        _power_epochs.resize(_subnets);
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            _power_epochs[subnet] = new Power_Module(_net[subnet], config);
+            _power_epochs[subnet]->InitEpochs();
+        }
+        _power_epochs[0]->EpochHeader(*_power_epoch_out);
+    }
+
+    vector<string> link_faults = tokenize_str( config.GetStr( "link_fault_schedule" ) );
+    for(size_t i = 0; i < link_faults.size(); ++i) {
+        vector<int> event = tokenize_int(link_faults[i]);
+        if((event.size() != 4) || (event[0] < 0) ||
+           (event[1] < 0) || (event[1] >= _net[0]->NumRouters()) ||
+           (event[2] < 0) || (event[2] >= _net[0]->GetRouter(event[1])->NumOutputs())) {
+            Error( "Invalid link_fault_schedule entry: " + link_faults[i] );
+        }
+        _link_faults.push_back(event);
+    }
+    sort(_link_faults.begin(), _link_faults.end());
+    _next_link_fault = 0;
+
+    _engine = NULL;
+    _region_time = 0;
+    if(config.GetInt( "parallel_regions" ) > 0) {
+        // the regions run the terminals of the plain traffic manager; the
+        // other simulation types act on all nodes at once every cycle
+        if((config.GetStr( "sim_type" ) != "latency") &&
+           (config.GetStr( "sim_type" ) != "throughput")) {
+            Error( "parallel_regions requires sim_type = latency or throughput." );
+        }
+        if(config.GetStr( "router" ) != "iq") {
+            Error( "parallel_regions requires router = iq." );
+        }
+        if(_noq) {
+            Error( "parallel_regions does not support noq." );
+        }
+        if(((watch_file != "") && (watch_file != "-")) || 
+           !watch_flits.empty() || !watch_packets.empty() ||
+           (config.GetStr( "watch_transactions" ) != "")) {
+            Error( "parallel_regions does not support watch lists." );
+        }
+        if(gEventTrace || gTrace) {
+            Error( "parallel_regions does not support event_trace or viewer_trace." );
+        }
+        if(gProfile) {
+            Error( "parallel_regions does not support profile." );
+        }
+        if(_trace_out) {
+            Error( "parallel_regions does not support trace_out." );
+        }
+        _engine = new ParallelEngine(config, _net, this);
+        _region_nodes.resize(_engine->NumRegions());
+        for(int n = 0; n < _nodes; ++n) {
+            int const region = _net[0]->GetNodeRegion(n);
+            for(int i = 1; i < _subnets; ++i) {
+                assert(_net[i]->GetNodeRegion(n) == region);
+            }
+            _region_nodes[region].push_back(n);
+        }
+        _region_generated.resize(_nodes);
+        _region_ejected.resize(_nodes);
+    }
   
-#ifdef TRACK_FLOWS
-    _injected_flits.resize(_classes, vector<int>(_nodes, 0));
-    _ejected_flits.resize(_classes, vector<int>(_nodes, 0));
+    _injected_flits.Init(_track_flows, _classes, _nodes);
+    _ejected_flits.Init(_track_flows, _classes, _nodes);
     string injected_flits_out_file = config.GetStr( "injected_flits_out" );
     if(injected_flits_out_file == "") {
         _injected_flits_out = NULL;
@@ -426,9 +593,7 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     } else {
         _active_packets_out = new ofstream(active_packets_out_file.c_str());
     }
-#endif
 
-#ifdef TRACK_CREDITS
     string used_credits_out_file = config.GetStr( "used_credits_out" );
     if(used_credits_out_file == "") {
         _used_credits_out = NULL;
@@ -447,7 +612,6 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     } else {
         _max_credits_out = new ofstream(max_credits_out_file.c_str());
     }
-#endif
 
     // ============ Statistics ============ 
 
@@ -455,22 +619,28 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _overall_min_plat.resize(_classes, 0.0);
     _overall_avg_plat.resize(_classes, 0.0);
     _overall_max_plat.resize(_classes, 0.0);
+    _overall_plat_stats.resize(_classes);
 
     _nlat_stats.resize(_classes);
     _overall_min_nlat.resize(_classes, 0.0);
     _overall_avg_nlat.resize(_classes, 0.0);
     _overall_max_nlat.resize(_classes, 0.0);
+    _overall_nlat_stats.resize(_classes);
 
     _flat_stats.resize(_classes);
     _overall_min_flat.resize(_classes, 0.0);
     _overall_avg_flat.resize(_classes, 0.0);
     _overall_max_flat.resize(_classes, 0.0);
+    _overall_flat_stats.resize(_classes);
 
     _frag_stats.resize(_classes);
     _overall_min_frag.resize(_classes, 0.0);
     _overall_avg_frag.resize(_classes, 0.0);
     _overall_max_frag.resize(_classes, 0.0);
 
+    _plat_batch_stats.resize(_classes);
+    _accepted_batch_stats.resize(_classes);
+
     if(_pair_stats){
         _pair_plat.resize(_classes);
         _pair_nlat.resize(_classes);
@@ -498,7 +668,6 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _overall_avg_accepted.resize(_classes, 0.0);
     _overall_max_accepted.resize(_classes, 0.0);
 
-#ifdef TRACK_STALLS
     _buffer_busy_stalls.resize(_classes);
     _buffer_conflict_stalls.resize(_classes);
     _buffer_full_stalls.resize(_classes);
@@ -509,7 +678,6 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _overall_buffer_full_stalls.resize(_classes, 0);
     _overall_buffer_reserved_stalls.resize(_classes, 0);
     _overall_crossbar_conflict_stalls.resize(_classes, 0);
-#endif
 
     for ( int c = 0; c < _classes; ++c ) {
         ostringstream tmp_name;
@@ -529,20 +697,43 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _stats[tmp_name.str()] = _flat_stats[c];
         tmp_name.str("");
 
+        // all samples of all simulations, for percentiles
+        tmp_name << "overall_plat_stat_" << c;
+        _overall_plat_stats[c] = new Stats( this, tmp_name.str( ) );
+        tmp_name.str("");
+
+        tmp_name << "overall_nlat_stat_" << c;
+        _overall_nlat_stats[c] = new Stats( this, tmp_name.str( ) );
+        tmp_name.str("");
+
+        tmp_name << "overall_flat_stat_" << c;
+        _overall_flat_stats[c] = new Stats( this, tmp_name.str( ) );
+        tmp_name.str("");
+
         tmp_name << "frag_stat_" << c;
         _frag_stats[c] = new Stats( this, tmp_name.str( ), 1.0, 100 );
         _stats[tmp_name.str()] = _frag_stats[c];
         tmp_name.str("");
 
+        tmp_name << "plat_batch_stat_" << c;
+        _plat_batch_stats[c] = new Stats( this, tmp_name.str( ) );
+        _stats[tmp_name.str()] = _plat_batch_stats[c];
+        tmp_name.str("");
+
+        tmp_name << "accepted_batch_stat_" << c;
+        _accepted_batch_stats[c] = new Stats( this, tmp_name.str( ) );
+        _stats[tmp_name.str()] = _accepted_batch_stats[c];
+        tmp_name.str("");
+
         tmp_name << "hop_stat_" << c;
         _hop_stats[c] = new Stats( this, tmp_name.str( ), 1.0, 20 );
         _stats[tmp_name.str()] = _hop_stats[c];
         tmp_name.str("");
 
         if(_pair_stats){
-            _pair_plat[c].resize(_nodes*_nodes);
-            _pair_nlat[c].resize(_nodes*_nodes);
-            _pair_flat[c].resize(_nodes*_nodes);
+            _pair_plat[c] = new PairStats( _nodes, _sparse_pair_stats, true );
+            _pair_nlat[c] = new PairStats( _nodes, _sparse_pair_stats );
+            _pair_flat[c] = new PairStats( _nodes, _sparse_pair_stats );
         }
 
         _sent_packets[c].resize(_nodes, 0);
@@ -550,33 +741,11 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         _sent_flits[c].resize(_nodes, 0);
         _accepted_flits[c].resize(_nodes, 0);
 
-#ifdef TRACK_STALLS
         _buffer_busy_stalls[c].resize(_subnets*_routers, 0);
         _buffer_conflict_stalls[c].resize(_subnets*_routers, 0);
         _buffer_full_stalls[c].resize(_subnets*_routers, 0);
         _buffer_reserved_stalls[c].resize(_subnets*_routers, 0);
         _crossbar_conflict_stalls[c].resize(_subnets*_routers, 0);
-#endif
-        if(_pair_stats){
-            for ( int i = 0; i < _nodes; ++i ) {
-                for ( int j = 0; j < _nodes; ++j ) {
-                    tmp_name << "pair_plat_stat_" << c << "_" << i << "_" << j;
-                    _pair_plat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
-                    _stats[tmp_name.str()] = _pair_plat[c][i*_nodes+j];
-                    tmp_name.str("");
-	  
-                    tmp_name << "pair_nlat_stat_" << c << "_" << i << "_" << j;
-                    _pair_nlat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
-                    _stats[tmp_name.str()] = _pair_nlat[c][i*_nodes+j];
-                    tmp_name.str("");
-	  
-                    tmp_name << "pair_flat_stat_" << c << "_" << i << "_" << j;
-                    _pair_flat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
-                    _stats[tmp_name.str()] = _pair_flat[c][i*_nodes+j];
-                    tmp_name.str("");
-                }
-            }
-        }
     }
 
     _slowest_flit.resize(_classes, -1);
@@ -589,6 +758,9 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
 TrafficManager::~TrafficManager( )
 {
 
+    // stop the region threads before anything they use goes away
+    if(_engine) delete _engine;
+
     for ( int source = 0; source < _nodes; ++source ) {
         for ( int subnet = 0; subnet < _subnets; ++subnet ) {
             delete _buf_states[source][subnet];
@@ -599,26 +771,32 @@ TrafficManager::~TrafficManager( )
         delete _plat_stats[c];
         delete _nlat_stats[c];
         delete _flat_stats[c];
+        delete _overall_plat_stats[c];
+        delete _overall_nlat_stats[c];
+        delete _overall_flat_stats[c];
         delete _frag_stats[c];
+        delete _plat_batch_stats[c];
+        delete _accepted_batch_stats[c];
         delete _hop_stats[c];
 
         delete _traffic_pattern[c];
         delete _injection_process[c];
         if(_pair_stats){
-            for ( int i = 0; i < _nodes; ++i ) {
-                for ( int j = 0; j < _nodes; ++j ) {
-                    delete _pair_plat[c][i*_nodes+j];
-                    delete _pair_nlat[c][i*_nodes+j];
-                    delete _pair_flat[c][i*_nodes+j];
-                }
-            }
+            delete _pair_plat[c];
+            delete _pair_nlat[c];
+            delete _pair_flat[c];
         }
     }
   
     if(gWatchOut && (gWatchOut != &cout)) delete gWatchOut;
     if(_stats_out && (_stats_out != &cout)) delete _stats_out;
+    if(_trace_out) delete _trace_out;
+    if(_util_sampler) delete _util_sampler;
+    for(size_t subnet = 0; subnet < _power_epochs.size(); ++subnet) {
+        delete _power_epochs[subnet];
+    }
+    if(_power_epoch_out) delete _power_epoch_out;
 
-#ifdef TRACK_FLOWS
     if(_injected_flits_out) delete _injected_flits_out;
     if(_received_flits_out) delete _received_flits_out;
     if(_stored_flits_out) delete _stored_flits_out;
@@ -626,13 +804,10 @@ TrafficManager::~TrafficManager( )
     if(_outstanding_credits_out) delete _outstanding_credits_out;
     if(_ejected_flits_out) delete _ejected_flits_out;
     if(_active_packets_out) delete _active_packets_out;
-#endif
 
-#ifdef TRACK_CREDITS
     if(_used_credits_out) delete _used_credits_out;
     if(_free_credits_out) delete _free_credits_out;
     if(_max_credits_out) delete _max_credits_out;
-#endif
 
     PacketReplyInfo::FreeAll();
     Flit::FreeAll();
@@ -675,7 +850,7 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
         _slowest_flit[f->cl] = f->id;
     _flat_stats[f->cl]->AddSample( f->atime - f->itime);
     if(_pair_stats){
-        _pair_flat[f->cl][f->src*_nodes+dest]->AddSample( f->atime - f->itime );
+        _pair_flat[f->cl]->AddSample( f->src, dest, f->atime - f->itime );
     }
       
     if ( f->tail ) {
@@ -704,12 +879,11 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
 
         //code the source of request, look carefully, its tricky ;)
         if (f->type == Flit::READ_REQUEST || f->type == Flit::WRITE_REQUEST) {
-            PacketReplyInfo* rinfo = PacketReplyInfo::New();
-            rinfo->source = f->src;
-            rinfo->time = f->atime;
-            rinfo->record = f->record;
-            rinfo->type = f->type;
-            _repliesPending[dest].push_back(rinfo);
+            // with parallel regions the destination's region queued the 
+            // reply when it ejected the flit
+            if(!_engine) {
+                _QueueReply(f, dest);
+            }
         } else {
             if(f->type == Flit::READ_REPLY || f->type == Flit::WRITE_REPLY  ){
                 _requestsOutstanding[dest]--;
@@ -733,8 +907,8 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
             _frag_stats[f->cl]->AddSample( (f->atime - head->atime) - (f->id - head->id) );
    
             if(_pair_stats){
-                _pair_plat[f->cl][f->src*_nodes+dest]->AddSample( f->atime - head->ctime );
-                _pair_nlat[f->cl][f->src*_nodes+dest]->AddSample( f->atime - head->itime );
+                _pair_plat[f->cl]->AddSample( f->src, dest, f->atime - head->ctime );
+                _pair_nlat[f->cl]->AddSample( f->src, dest, f->atime - head->itime );
             }
         }
     
@@ -751,14 +925,25 @@ void TrafficManager::_RetireFlit( Flit *f, int dest )
     }
 }
 
-int TrafficManager::_IssuePacket( int source, int cl )
+void TrafficManager::_QueueReply( Flit const * f, int dest )
+{
+    PacketReplyInfo* rinfo = PacketReplyInfo::New();
+    rinfo->source = f->src;
+    rinfo->pid = f->pid;
+    rinfo->time = f->atime;
+    rinfo->record = f->record;
+    rinfo->type = f->type;
+    _repliesPending[dest].push_back(rinfo);
+}
+
+int TrafficManager::_IssuePacket( int source, int cl, int time )
 {
     int result = 0;
     if(_use_read_write[cl]){ //use read and write
         //check queue for waiting replies.
         //check to make sure it is on time yet
         if (!_repliesPending[source].empty()) {
-            if(_repliesPending[source].front()->time <= _time) {
+            if(_repliesPending[source].front()->time <= time) {
                 result = -1;
             }
         } else {
@@ -789,11 +974,9 @@ void TrafficManager::_GeneratePacket( int source, int stype,
 
     Flit::FlitType packet_type = Flit::ANY_TYPE;
     int size = _GetNextPacketSize(cl); //input size 
-    int pid = _cur_pid++;
-    assert(_cur_pid);
     int packet_destination = _traffic_pattern[cl]->dest(source);
     bool record = false;
-    bool watch = gWatchOut && (_packets_to_watch.count(pid) > 0);
+    int dep = -1;
     if(_use_read_write[cl]){
         if(stype > 0) {
             if (stype == 1) {
@@ -823,11 +1006,35 @@ void TrafficManager::_GeneratePacket( int source, int stype,
             packet_destination = rinfo->source;
             time = rinfo->time;
             record = rinfo->record;
+            dep = rinfo->pid;
             _repliesPending[source].pop_front();
             rinfo->Free();
         }
     }
 
+    _EnqueuePacket( source, packet_destination, size, cl, time, packet_type, record, dep );
+}
+
+int TrafficManager::_EnqueuePacket( int source, int packet_destination, 
+                                    int size, int cl, int time, 
+                                    Flit::FlitType packet_type, bool record,
+                                    int dep )
+{
+    // with parallel regions the main thread numbers the packet and its
+    // flits when it syncs with the regions
+    int pid = -1;
+    if(!_engine) {
+        pid = _cur_pid++;
+        assert(_cur_pid);
+    }
+
+    // every packet is captured, so record indices coincide with packet IDs
+    if(_trace_out) {
+        _trace_out->Write(_time, source, packet_destination, size, cl, 
+                          packet_type, dep);
+    }
+    bool watch = gWatchOut && (_packets_to_watch.count(pid) > 0);
+
     if ((packet_destination <0) || (packet_destination >= _nodes)) {
         ostringstream err;
         err << "Incorrect packet destination " << packet_destination
@@ -854,8 +1061,10 @@ void TrafficManager::_GeneratePacket( int source, int stype,
   
     for ( int i = 0; i < size; ++i ) {
         Flit * f  = Flit::New();
-        f->id     = _cur_id++;
-        assert(_cur_id);
+        if(!_engine) {
+            f->id     = _cur_id++;
+            assert(_cur_id);
+        }
         f->pid    = pid;
         f->watch  = watch | (gWatchOut && (_flits_to_watch.count(f->id) > 0));
         f->subnetwork = subnetwork;
@@ -864,9 +1073,13 @@ void TrafficManager::_GeneratePacket( int source, int stype,
         f->record = record;
         f->cl     = cl;
 
-        _total_in_flight_flits[f->cl].insert(make_pair(f->id, f));
-        if(record) {
-            _measured_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+        if(_engine) {
+            _region_generated[source].push_back(make_pair(GetSimTime(), f));
+        } else {
+            _total_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+            if(record) {
+                _measured_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+            }
         }
     
         if(gTrace){
@@ -917,363 +1130,578 @@ void TrafficManager::_GeneratePacket( int source, int stype,
 
         _partial_packets[source][cl].push_back( f );
     }
+
+    return pid;
 }
 
 void TrafficManager::_Inject(){
 
     for ( int input = 0; input < _nodes; ++input ) {
-        for ( int c = 0; c < _classes; ++c ) {
-            // Potentially generate packets for any (input,class)
-            // that is currently empty
-            if ( _partial_packets[input][c].empty() ) {
-                bool generated = false;
-                while( !generated && ( _qtime[input][c] <= _time ) ) {
-                    int stype = _IssuePacket( input, c );
+        _InjectNode( input, _time );
+    }
+}
+
+void TrafficManager::_InjectNode( int input, int time )
+{
+    if(_random_streams) {
+        gRandomStream = &_node_random[input];
+    }
+    for ( int c = 0; c < _classes; ++c ) {
+        // Potentially generate packets for any (input,class)
+        // that is currently empty
+        if ( _partial_packets[input][c].empty() ) {
+            bool generated = false;
+            while( !generated && ( _qtime[input][c] <= time ) ) {
+                int stype = _IssuePacket( input, c, time );
 	  
-                    if ( stype != 0 ) { //generate a packet
-                        _GeneratePacket( input, stype, c, 
-                                         _include_queuing==1 ? 
-                                         _qtime[input][c] : _time );
-                        generated = true;
-                    }
-                    // only advance time if this is not a reply packet
-                    if(!_use_read_write[c] || (stype >= 0)){
-                        ++_qtime[input][c];
-                    }
+                if ( stype != 0 ) { //generate a packet
+                    _GeneratePacket( input, stype, c, 
+                                     _include_queuing==1 ? 
+                                     _qtime[input][c] : time );
+                    generated = true;
                 }
-	
-                if ( ( _sim_state == draining ) && 
-                     ( _qtime[input][c] > _drain_time ) ) {
-                    _qdrained[input][c] = true;
+                // only advance time if this is not a reply packet
+                if(!_use_read_write[c] || (stype >= 0)){
+                    ++_qtime[input][c];
                 }
             }
+	
+            if ( ( _sim_state == draining ) && 
+                 ( _qtime[input][c] > _drain_time ) ) {
+                _qdrained[input][c] = true;
+            }
         }
     }
+    gRandomStream = 0;
 }
 
-void TrafficManager::_Step( )
+Flit * TrafficManager::_ReadNode( int subnet, int n )
 {
-    bool flits_in_flight = false;
-    for(int c = 0; c < _classes; ++c) {
-        flits_in_flight |= !_total_in_flight_flits[c].empty();
-    }
-    if(flits_in_flight && (_deadlock_timer++ >= _deadlock_warn_timeout)){
-        _deadlock_timer = 0;
-        cout << "WARNING: Possible network deadlock.\n";
-    }
-
-    vector<map<int, Flit *> > flits(_subnets);
-  
-    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
-        for ( int n = 0; n < _nodes; ++n ) {
-            Flit * const f = _net[subnet]->ReadFlit( n );
-            if ( f ) {
-                if(f->watch) {
-                    *gWatchOut << GetSimTime() << " | "
-                               << "node" << n << " | "
-                               << "Ejecting flit " << f->id
-                               << " (packet " << f->pid << ")"
-                               << " from VC " << f->vc
-                               << "." << endl;
-                }
-                flits[subnet].insert(make_pair(n, f));
-                if((_sim_state == warming_up) || (_sim_state == running)) {
-                    ++_accepted_flits[f->cl][n];
-                    if(f->tail) {
-                        ++_accepted_packets[f->cl][n];
-                    }
-                }
+    Flit * const f = _net[subnet]->ReadFlit( n );
+    if ( f ) {
+        if(f->watch) {
+            *gWatchOut << GetSimTime() << " | "
+                       << "node" << n << " | "
+                       << "Ejecting flit " << f->id
+                       << " (packet " << f->pid << ")"
+                       << " from VC " << f->vc
+                       << "." << endl;
+        }
+        if(gEventTrace) {
+            gEventTrace->Record(EventTrace::EJECT, f, n, -1, f->vc);
+        }
+        _ejected[subnet][n] = f;
+        if((_sim_state == warming_up) || (_sim_state == running)) {
+            ++_accepted_flits[f->cl][n];
+            if(f->tail) {
+                ++_accepted_packets[f->cl][n];
             }
+        }
+    }
 
-            Credit * const c = _net[subnet]->ReadCredit( n );
-            if ( c ) {
-#ifdef TRACK_FLOWS
-                for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-                    int const vc = *iter;
-                    assert(!_outstanding_classes[n][subnet][vc].empty());
-                    int cl = _outstanding_classes[n][subnet][vc].front();
-                    _outstanding_classes[n][subnet][vc].pop();
-                    assert(_outstanding_credits[cl][subnet][n] > 0);
-                    --_outstanding_credits[cl][subnet][n];
-                }
-#endif
-                _buf_states[n][subnet]->ProcessCredit(c);
-                c->Free();
+    Credit * const c = _net[subnet]->ReadCredit( n );
+    if ( c ) {
+        if(_track_flows) {
+            for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+                int const vc = *iter;
+                assert(!_outstanding_classes[n][subnet][vc].empty());
+                int cl = _outstanding_classes[n][subnet][vc].front();
+                _outstanding_classes[n][subnet][vc].pop();
+                assert(_outstanding_credits[cl][subnet][n] > 0);
+                --_outstanding_credits[cl][subnet][n];
             }
         }
-        _net[subnet]->ReadInputs( );
+        _buf_states[n][subnet]->ProcessCredit(c);
+        c->Free();
     }
-  
-    if ( !_empty_network ) {
-        _Inject();
-    }
-
-    for(int subnet = 0; subnet < _subnets; ++subnet) {
+    return f;
+}
 
-        for(int n = 0; n < _nodes; ++n) {
+void TrafficManager::_SendNode( int subnet, int n, int time )
+{
+    unsigned long long * const node_stream = 
+        _random_streams ? &_node_random[n] : 0;
+    gRandomStream = node_stream;
 
-            Flit * f = NULL;
+    Flit * f = NULL;
 
-            BufferState * const dest_buf = _buf_states[n][subnet];
+    BufferState * const dest_buf = _buf_states[n][subnet];
 
-            int const last_class = _last_class[n][subnet];
+    int const last_class = _last_class[n][subnet];
 
-            int class_limit = _classes;
+    int class_limit = _classes;
 
-            if(_hold_switch_for_packet) {
-                list<Flit *> const & pp = _partial_packets[n][last_class];
-                if(!pp.empty() && !pp.front()->head && 
-                   !dest_buf->IsFullFor(pp.front()->vc)) {
-                    f = pp.front();
-                    assert(f->vc == _last_vc[n][subnet][last_class]);
+    if(_hold_switch_for_packet) {
+        list<Flit *> const & pp = _partial_packets[n][last_class];
+        if(!pp.empty() && !pp.front()->head && 
+           !dest_buf->IsFullFor(pp.front()->vc)) {
+            f = pp.front();
+            assert(f->vc == _last_vc[n][subnet][last_class]);
 
-                    // if we're holding the connection, we don't need to check that class 
-                    // again in the for loop
-                    --class_limit;
-                }
-            }
+            // if we're holding the connection, we don't need to check that class 
+            // again in the for loop
+            --class_limit;
+        }
+    }
 
-            for(int i = 1; i <= class_limit; ++i) {
+    for(int i = 1; i <= class_limit; ++i) {
 
-                int const c = (last_class + i) % _classes;
+        int const c = (last_class + i) % _classes;
 
-                list<Flit *> const & pp = _partial_packets[n][c];
+        list<Flit *> const & pp = _partial_packets[n][c];
 
-                if(pp.empty()) {
-                    continue;
-                }
+        if(pp.empty()) {
+            continue;
+        }
 
-                Flit * const cf = pp.front();
-                assert(cf);
-                assert(cf->cl == c);
+        Flit * const cf = pp.front();
+        assert(cf);
+        assert(cf->cl == c);
 	
-                if(cf->subnetwork != subnet) {
-                    continue;
-                }
+        if(cf->subnetwork != subnet) {
+            continue;
+        }
 
-                if(f && (f->pri >= cf->pri)) {
-                    continue;
-                }
+        if(f && (f->pri >= cf->pri)) {
+            continue;
+        }
 
-                if(cf->head && cf->vc == -1) { // Find first available VC
+        if(cf->head && cf->vc == -1) { // Find first available VC
 	  
-                    OutputSet route_set;
-                    _rf(NULL, cf, -1, &route_set, true);
-                    set<OutputSet::sSetElement> const & os = route_set.GetSet();
-                    assert(os.size() == 1);
-                    OutputSet::sSetElement const & se = *os.begin();
-                    assert(se.output_port == -1);
-                    int vc_start = se.vc_start;
-                    int vc_end = se.vc_end;
-                    int vc_count = vc_end - vc_start + 1;
-                    if(_noq) {
-                        assert(_lookahead_routing);
-                        const FlitChannel * inject = _net[subnet]->GetInject(n);
-                        const Router * router = inject->GetSink();
-                        assert(router);
-                        int in_channel = inject->GetSinkPort();
-
-                        // NOTE: Because the lookahead is not for injection, but for the 
-                        // first hop, we have to temporarily set cf's VC to be non-negative 
-                        // in order to avoid seting of an assertion in the routing function.
-                        cf->vc = vc_start;
-                        _rf(router, cf, in_channel, &cf->la_route_set, false);
-                        cf->vc = -1;
+            OutputSet route_set;
+            _rf(NULL, cf, -1, &route_set, true);
+            set<OutputSet::sSetElement> const & os = route_set.GetSet();
+            assert(os.size() == 1);
+            OutputSet::sSetElement const & se = *os.begin();
+            assert(se.output_port == -1);
+            int vc_start = se.vc_start;
+            int vc_end = se.vc_end;
+            int vc_count = vc_end - vc_start + 1;
+            if(_noq) {
+                assert(_lookahead_routing);
+                const FlitChannel * inject = _net[subnet]->GetInject(n);
+                const Router * router = inject->GetSink();
+                assert(router);
+                int in_channel = inject->GetSinkPort();
+
+                // NOTE: Because the lookahead is not for injection, but for the 
+                // first hop, we have to temporarily set cf's VC to be non-negative 
+                // in order to avoid seting of an assertion in the routing function.
+                cf->vc = vc_start;
+                if(_random_streams) {
+                    gRandomStream = router->RandomStream();
+                }
+                _rf(router, cf, in_channel, &cf->la_route_set, false);
+                gRandomStream = node_stream;
+                cf->vc = -1;
 
-                        if(cf->watch) {
-                            *gWatchOut << GetSimTime() << " | "
-                                       << "node" << n << " | "
-                                       << "Generating lookahead routing info for flit " << cf->id
-                                       << " (NOQ)." << endl;
-                        }
-                        set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
-                        assert(sl.size() == 1);
-                        int next_output = sl.begin()->output_port;
-                        vc_count /= router->NumOutputs();
-                        vc_start += next_output * vc_count;
-                        vc_end = vc_start + vc_count - 1;
-                        assert(vc_start >= se.vc_start && vc_start <= se.vc_end);
-                        assert(vc_end >= se.vc_start && vc_end <= se.vc_end);
-                        assert(vc_start <= vc_end);
-                    }
-                    if(cf->watch) {
-                        *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                                   << "Finding output VC for flit " << cf->id
-                                   << ":" << endl;
-                    }
-                    for(int i = 1; i <= vc_count; ++i) {
-                        int const lvc = _last_vc[n][subnet][c];
-                        int const vc =
-                            (lvc < vc_start || lvc > vc_end) ?
-                            vc_start :
-                            (vc_start + (lvc - vc_start + i) % vc_count);
-                        assert((vc >= vc_start) && (vc <= vc_end));
-                        if(!dest_buf->IsAvailableFor(vc)) {
-                            if(cf->watch) {
-                                *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                                           << "  Output VC " << vc << " is busy." << endl;
-                            }
-                        } else {
-                            if(dest_buf->IsFullFor(vc)) {
-                                if(cf->watch) {
-                                    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                                               << "  Output VC " << vc << " is full." << endl;
-                                }
-                            } else {
-                                if(cf->watch) {
-                                    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                                               << "  Selected output VC " << vc << "." << endl;
-                                }
-                                cf->vc = vc;
-                                break;
-                            }
-                        }
-                    }
+                if(cf->watch) {
+                    *gWatchOut << GetSimTime() << " | "
+                               << "node" << n << " | "
+                               << "Generating lookahead routing info for flit " << cf->id
+                               << " (NOQ)." << endl;
                 }
-	
-                if(cf->vc == -1) {
+                set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
+                assert(sl.size() == 1);
+                int next_output = sl.begin()->output_port;
+                vc_count /= router->NumOutputs();
+                vc_start += next_output * vc_count;
+                vc_end = vc_start + vc_count - 1;
+                assert(vc_start >= se.vc_start && vc_start <= se.vc_end);
+                assert(vc_end >= se.vc_start && vc_end <= se.vc_end);
+                assert(vc_start <= vc_end);
+            }
+            if(cf->watch) {
+                *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                           << "Finding output VC for flit " << cf->id
+                           << ":" << endl;
+            }
+            for(int i = 1; i <= vc_count; ++i) {
+                int const lvc = _last_vc[n][subnet][c];
+                int const vc =
+                    (lvc < vc_start || lvc > vc_end) ?
+                    vc_start :
+                    (vc_start + (lvc - vc_start + i) % vc_count);
+                assert((vc >= vc_start) && (vc <= vc_end));
+                if(!dest_buf->IsAvailableFor(vc)) {
                     if(cf->watch) {
                         *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                                   << "No output VC found for flit " << cf->id
-                                   << "." << endl;
+                                   << "  Output VC " << vc << " is busy." << endl;
                     }
                 } else {
-                    if(dest_buf->IsFullFor(cf->vc)) {
+                    if(dest_buf->IsFullFor(vc)) {
                         if(cf->watch) {
                             *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                                       << "Selected output VC " << cf->vc
-                                       << " is full for flit " << cf->id
-                                       << "." << endl;
+                                       << "  Output VC " << vc << " is full." << endl;
                         }
                     } else {
-                        f = cf;
+                        if(cf->watch) {
+                            *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                                       << "  Selected output VC " << vc << "." << endl;
+                        }
+                        cf->vc = vc;
+                        break;
                     }
                 }
             }
+        }
+	
+        if(cf->vc == -1) {
+            if(cf->watch) {
+                *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                           << "No output VC found for flit " << cf->id
+                           << "." << endl;
+            }
+        } else {
+            if(dest_buf->IsFullFor(cf->vc)) {
+                if(cf->watch) {
+                    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                               << "Selected output VC " << cf->vc
+                               << " is full for flit " << cf->id
+                               << "." << endl;
+                }
+            } else {
+                f = cf;
+            }
+        }
+    }
 
-            if(f) {
+    if(f) {
 
-                assert(f->subnetwork == subnet);
+        assert(f->subnetwork == subnet);
 
-                int const c = f->cl;
+        int const c = f->cl;
 
-                if(f->head) {
+        if(f->head) {
 	  
-                    if (_lookahead_routing) {
-                        if(!_noq) {
-                            const FlitChannel * inject = _net[subnet]->GetInject(n);
-                            const Router * router = inject->GetSink();
-                            assert(router);
-                            int in_channel = inject->GetSinkPort();
-                            _rf(router, f, in_channel, &f->la_route_set, false);
-                            if(f->watch) {
-                                *gWatchOut << GetSimTime() << " | "
-                                           << "node" << n << " | "
-                                           << "Generating lookahead routing info for flit " << f->id
-                                           << "." << endl;
-                            }
-                        } else if(f->watch) {
-                            *gWatchOut << GetSimTime() << " | "
-                                       << "node" << n << " | "
-                                       << "Already generated lookahead routing info for flit " << f->id
-                                       << " (NOQ)." << endl;
-                        }
-                    } else {
-                        f->la_route_set.Clear();
+            if (_lookahead_routing) {
+                if(!_noq) {
+                    const FlitChannel * inject = _net[subnet]->GetInject(n);
+                    const Router * router = inject->GetSink();
+                    assert(router);
+                    int in_channel = inject->GetSinkPort();
+                    if(_random_streams) {
+                        gRandomStream = router->RandomStream();
                     }
-
-                    dest_buf->TakeBuffer(f->vc);
-                    _last_vc[n][subnet][c] = f->vc;
+                    _rf(router, f, in_channel, &f->la_route_set, false);
+                    gRandomStream = node_stream;
+                    if(f->watch) {
+                        *gWatchOut << GetSimTime() << " | "
+                                   << "node" << n << " | "
+                                   << "Generating lookahead routing info for flit " << f->id
+                                   << "." << endl;
+                    }
+                } else if(f->watch) {
+                    *gWatchOut << GetSimTime() << " | "
+                               << "node" << n << " | "
+                               << "Already generated lookahead routing info for flit " << f->id
+                               << " (NOQ)." << endl;
                 }
+            } else {
+                f->la_route_set.Clear();
+            }
+
+            dest_buf->TakeBuffer(f->vc);
+            _last_vc[n][subnet][c] = f->vc;
+        }
 	
-                _last_class[n][subnet] = c;
+        _last_class[n][subnet] = c;
 
-                _partial_packets[n][c].pop_front();
+        _partial_packets[n][c].pop_front();
 
-#ifdef TRACK_FLOWS
-                ++_outstanding_credits[c][subnet][n];
-                _outstanding_classes[n][subnet][f->vc].push(c);
-#endif
+        if(_track_flows) {
+            ++_outstanding_credits[c][subnet][n];
+            _outstanding_classes[n][subnet][f->vc].push(c);
+        }
 
-                dest_buf->SendingFlit(f);
+        dest_buf->SendingFlit(f);
 	
-                if(_pri_type == network_age_based) {
-                    f->pri = numeric_limits<int>::max() - _time;
-                    assert(f->pri >= 0);
-                }
+        if(_pri_type == network_age_based) {
+            f->pri = numeric_limits<int>::max() - time;
+            assert(f->pri >= 0);
+        }
 	
-                if(f->watch) {
-                    *gWatchOut << GetSimTime() << " | "
-                               << "node" << n << " | "
-                               << "Injecting flit " << f->id
-                               << " into subnet " << subnet
-                               << " at time " << _time
-                               << " with priority " << f->pri
-                               << "." << endl;
-                }
-                f->itime = _time;
+        if(f->watch) {
+            *gWatchOut << GetSimTime() << " | "
+                       << "node" << n << " | "
+                       << "Injecting flit " << f->id
+                       << " into subnet " << subnet
+                       << " at time " << time
+                       << " with priority " << f->pri
+                       << "." << endl;
+        }
+        f->itime = time;
+        if(gEventTrace) {
+            gEventTrace->Record(EventTrace::INJECT, f, n, -1, f->vc, 
+                                f->dest);
+        }
 
-                // Pass VC "back"
-                if(!_partial_packets[n][c].empty() && !f->tail) {
-                    Flit * const nf = _partial_packets[n][c].front();
-                    nf->vc = f->vc;
-                }
+        // Pass VC "back"
+        if(!_partial_packets[n][c].empty() && !f->tail) {
+            Flit * const nf = _partial_packets[n][c].front();
+            nf->vc = f->vc;
+        }
 	
-                if((_sim_state == warming_up) || (_sim_state == running)) {
-                    ++_sent_flits[c][n];
-                    if(f->head) {
-                        ++_sent_packets[c][n];
-                    }
-                }
+        if((_sim_state == warming_up) || (_sim_state == running)) {
+            ++_sent_flits[c][n];
+            if(f->head) {
+                ++_sent_packets[c][n];
+            }
+        }
 	
-#ifdef TRACK_FLOWS
-                ++_injected_flits[c][n];
-#endif
+        ++_injected_flits(c, n);
 	
-                _net[subnet]->WriteFlit(f, n);
+        _net[subnet]->WriteFlit(f, n);
 	
+    }
+    gRandomStream = 0;
+}
+
+void TrafficManager::_AcceptNode( int subnet, int n, int time )
+{
+    Flit * const f = _ejected[subnet][n];
+    if(!f) {
+        return;
+    }
+    _ejected[subnet][n] = NULL;
+
+    f->atime = time;
+    if(f->watch) {
+        *gWatchOut << GetSimTime() << " | "
+                   << "node" << n << " | "
+                   << "Injecting credit for VC " << f->vc 
+                   << " into subnet " << subnet 
+                   << "." << endl;
+    }
+    Credit * const c = Credit::New();
+    c->vc.insert(f->vc);
+    _net[subnet]->WriteCredit(c, n);
+	
+    ++_ejected_flits(f->cl, n);
+
+    if(_engine) {
+        // the main thread retires the flit when it syncs with the regions
+        if(f->tail && 
+           ((f->type == Flit::READ_REQUEST) || (f->type == Flit::WRITE_REQUEST))) {
+            _QueueReply(f, n);
+        }
+        _region_ejected[n].push_back(make_pair(time, f));
+    } else {
+        _RetireFlit(f, n);
+    }
+}
+
+void TrafficManager::_StepRegion( int region, int time )
+{
+    vector<int> const & nodes = _region_nodes[region];
+
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+        for ( size_t i = 0; i < nodes.size(); ++i ) {
+            _ReadNode( subnet, nodes[i] );
+        }
+    }
+
+    if ( !_empty_network ) {
+        for ( size_t i = 0; i < nodes.size(); ++i ) {
+            _InjectNode( nodes[i], time );
+        }
+    }
+
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+        for ( size_t i = 0; i < nodes.size(); ++i ) {
+            _SendNode( subnet, nodes[i], time );
+        }
+    }
+
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+        for ( size_t i = 0; i < nodes.size(); ++i ) {
+            _AcceptNode( subnet, nodes[i], time );
+        }
+    }
+}
+
+void TrafficManager::_SyncRegions( )
+{
+    if(!_engine) {
+        return;
+    }
+    _engine->Sync();
+
+    // take over what the regions did since the last sync, cycle by cycle
+    // and in the order of a sequential step: the deadlock check, the new
+    // packets, then the flits ejected
+    vector<size_t> generated(_nodes, 0);
+    vector<size_t> ejected(_nodes, 0);
+    for ( int t = _region_time; t < _time; ++t ) {
+        bool flits_in_flight = false;
+        for(int c = 0; c < _classes; ++c) {
+            flits_in_flight |= !_total_in_flight_flits[c].empty();
+        }
+        if(flits_in_flight && (_deadlock_timer++ >= _deadlock_warn_timeout)){
+            _deadlock_timer = 0;
+            cout << "WARNING: Possible network deadlock.\n";
+        }
+
+        for ( int n = 0; n < _nodes; ++n ) {
+            vector<pair<int, Flit *> > const & flits = _region_generated[n];
+            int pid = -1;
+            for ( size_t & i = generated[n]; 
+                  ( i < flits.size() ) && ( flits[i].first == t ); ++i ) {
+                Flit * const f = flits[i].second;
+                if(f->head) {
+                    pid = _cur_pid++;
+                    assert(_cur_pid);
+                }
+                f->pid = pid;
+                f->id = _cur_id++;
+                assert(_cur_id);
+                _total_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+                if(f->record) {
+                    _measured_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+                }
+            }
+        }
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            for ( int n = 0; n < _nodes; ++n ) {
+                vector<pair<int, Flit *> > const & flits = _region_ejected[n];
+                for ( size_t & i = ejected[n];
+                      ( i < flits.size() ) && ( flits[i].first == t ) &&
+                          ( flits[i].second->subnetwork == subnet ); ++i ) {
+                    _RetireFlit(flits[i].second, n);
+                }
             }
         }
     }
+    for ( int n = 0; n < _nodes; ++n ) {
+        assert(generated[n] == _region_generated[n].size());
+        assert(ejected[n] == _region_ejected[n].size());
+        _region_generated[n].clear();
+        _region_ejected[n].clear();
+    }
+    _region_time = _time;
+}
 
-    for(int subnet = 0; subnet < _subnets; ++subnet) {
-        for(int n = 0; n < _nodes; ++n) {
-            map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
-            if(iter != flits[subnet].end()) {
-                Flit * const f = iter->second;
+void TrafficManager::_Step( )
+{
+    if(_engine && (_next_link_fault < _link_faults.size()) &&
+       (_link_faults[_next_link_fault][0] <= _time)) {
+        _SyncRegions();
+    }
+    while((_next_link_fault < _link_faults.size()) &&
+          (_link_faults[_next_link_fault][0] <= _time)) {
+        vector<int> const & event = _link_faults[_next_link_fault];
+        pair<int, int> const link(event[1], event[2]);
+        if(_link_fault_initial.find(link) == _link_fault_initial.end()) {
+            _link_fault_initial[link] = _router[0][event[1]]->IsFaultyOutput(event[2]);
+        }
+        cout << _time << " | " << (event[3] ? "Failing" : "Restoring")
+             << " output " << event[2] << " of router " << event[1] << endl;
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            _net[subnet]->OutChannelFault(event[1], event[2], event[3] != 0);
+        }
+        ++_next_link_fault;
+    }
 
-                f->atime = _time;
-                if(f->watch) {
-                    *gWatchOut << GetSimTime() << " | "
-                               << "node" << n << " | "
-                               << "Injecting credit for VC " << f->vc 
-                               << " into subnet " << subnet 
-                               << "." << endl;
+    if(_engine) {
+        // the regions run the cycle, terminals included
+        _engine->Release(_time + 1);
+    } else {
+        bool flits_in_flight = false;
+        for(int c = 0; c < _classes; ++c) {
+            flits_in_flight |= !_total_in_flight_flits[c].empty();
+        }
+        if(flits_in_flight && (_deadlock_timer++ >= _deadlock_warn_timeout)){
+            _deadlock_timer = 0;
+            cout << "WARNING: Possible network deadlock.\n";
+        }
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            ProfileScope prof(_prof_eject);
+            for ( int n = 0; n < _nodes; ++n ) {
+                if ( _ReadNode( subnet, n ) ) {
+                    ++_prof_flits;
                 }
-                Credit * const c = Credit::New();
-                c->vc.insert(f->vc);
-                _net[subnet]->WriteCredit(c, n);
-	
-#ifdef TRACK_FLOWS
-                ++_ejected_flits[f->cl][n];
-#endif
-	
-                _RetireFlit(f, n);
             }
         }
-        flits[subnet].clear();
-        _net[subnet]->Evaluate( );
-        _net[subnet]->WriteOutputs( );
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            ProfileScope prof(_prof_read_inputs);
+            _net[subnet]->ReadInputs( );
+        }
+  
+        if ( !_empty_network ) {
+            ProfileScope prof(_prof_inject);
+            _Inject();
+        }
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            ProfileScope prof(_prof_inject_flits);
+            for ( int n = 0; n < _nodes; ++n ) {
+                _SendNode( subnet, n, _time );
+            }
+        }
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            ProfileScope prof(_prof_retire);
+            for ( int n = 0; n < _nodes; ++n ) {
+                _AcceptNode( subnet, n, _time );
+            }
+        }
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            ProfileScope prof(_prof_evaluate);
+            _net[subnet]->Evaluate( );
+        }
+
+        for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+            ProfileScope prof(_prof_write_outputs);
+            _net[subnet]->WriteOutputs( );
+        }
     }
 
     ++_time;
     assert(_time);
+    // the regions run ahead of the traffic manager up to its next read
+    // of the network: a sample, or every cycle while draining
+    if(_engine && 
+       ((_sim_state == draining) ||
+        (_util_sampler && (_time % _util_sample_period == 0)) ||
+        (_power_epoch_out && (_time % _power_epoch_period == 0)))) {
+        _SyncRegions();
+    }
+    if(_util_sampler && (_time % _util_sample_period == 0)) {
+        _util_sampler->Sample(_time);
+    }
+    if(_power_epoch_out && (_time % _power_epoch_period == 0)) {
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            _power_epochs[subnet]->Epoch(*_power_epoch_out, subnet, _time, 
+                                         _power_epoch_period);
+        }
+    }
     if(gTrace){
         cout<<"TIME "<<_time<<endl;
     }
 
 }
   
+void TrafficManager::_RestoreLinkFaults( )
+{
+    for(map<pair<int, int>, bool>::const_iterator iter = _link_fault_initial.begin();
+        iter != _link_fault_initial.end(); ++iter) {
+        int const router = iter->first.first;
+        int const port = iter->first.second;
+        if(_router[0][router]->IsFaultyOutput(port) != iter->second) {
+            cout << "Resetting output " << port << " of router " << router 
+                 << " for the next simulation" << endl;
+            for(int subnet = 0; subnet < _subnets; ++subnet) {
+                _net[subnet]->OutChannelFault(router, port, iter->second);
+            }
+        }
+    }
+    _link_fault_initial.clear();
+}
+
 bool TrafficManager::_PacketsOutstanding( ) const
 {
     for ( int c = 0; c < _classes; ++c ) {
@@ -1313,26 +1741,23 @@ void TrafficManager::_ClearStats( )
 
         _frag_stats[c]->Clear( );
 
+        _plat_batch_stats[c]->Clear( );
+        _accepted_batch_stats[c]->Clear( );
+
         _sent_packets[c].assign(_nodes, 0);
         _accepted_packets[c].assign(_nodes, 0);
         _sent_flits[c].assign(_nodes, 0);
         _accepted_flits[c].assign(_nodes, 0);
 
-#ifdef TRACK_STALLS
         _buffer_busy_stalls[c].assign(_subnets*_routers, 0);
         _buffer_conflict_stalls[c].assign(_subnets*_routers, 0);
         _buffer_full_stalls[c].assign(_subnets*_routers, 0);
         _buffer_reserved_stalls[c].assign(_subnets*_routers, 0);
         _crossbar_conflict_stalls[c].assign(_subnets*_routers, 0);
-#endif
         if(_pair_stats){
-            for ( int i = 0; i < _nodes; ++i ) {
-                for ( int j = 0; j < _nodes; ++j ) {
-                    _pair_plat[c][i*_nodes+j]->Clear( );
-                    _pair_nlat[c][i*_nodes+j]->Clear( );
-                    _pair_flat[c][i*_nodes+j]->Clear( );
-                }
-            }
+            _pair_plat[c]->Clear( );
+            _pair_nlat[c]->Clear( );
+            _pair_flat[c]->Clear( );
         }
         _hop_stats[c]->Clear();
 
@@ -1414,6 +1839,75 @@ void TrafficManager::_DisplayRemaining( ostream & os ) const
     }
 }
 
+// MSER-5 truncation rule: group the series into batches of five and find 
+// the number of leading observations whose removal minimizes the standard 
+// error of the mean of the rest; fewer than five trailing batches are 
+// never considered on their own, as their statistic is too noisy.  
+// Returns -1 while there are too few batches or while the minimum lies 
+// in the second half of the series, i.e., the transient may not be over 
+// yet.
+int TrafficManager::_MserTruncation( vector<double> const & series ) const
+{
+    int const batches = series.size() / 5;
+    if(batches < _mser_min_batches) {
+        return -1;
+    }
+    vector<double> z(batches, 0.0);
+    for(int b = 0; b < batches; ++b) {
+        for(int i = 0; i < 5; ++i) {
+            z[b] += series[5 * b + i];
+        }
+        z[b] /= 5.0;
+    }
+    double sum = 0.0;
+    double squared_sum = 0.0;
+    double best = numeric_limits<double>::infinity();
+    int best_d = -1;
+    for(int d = batches - 1; d >= 0; --d) {
+        sum += z[d];
+        squared_sum += z[d] * z[d];
+        double const k = (double)(batches - d);
+        if(k < 5.0) {
+            continue;
+        }
+        double const mser = max(squared_sum - sum * sum / k, 0.0) / (k * k);
+        if(mser <= best) {
+            best = mser;
+            best_d = d;
+        }
+    }
+    return (best_d <= batches / 2) ? (5 * best_d) : -1;
+}
+
+// Half-width of the confidence interval of the mean of the batch means 
+// collected in s; precision receives the half-width relative to the mean.
+double TrafficManager::_ConfidenceInterval( Stats const * s, double * precision ) const
+{
+    int const n = s->NumSamples();
+    if(n < _ci_min_batches) {
+        *precision = numeric_limits<double>::infinity();
+        return numeric_limits<double>::infinity();
+    }
+    double const variance = max(s->Variance(), 0.0) * (double)n / (double)(n - 1);
+    double const width = student_t_quantile(0.5 + 0.5 * _ci_confidence, n - 1) * 
+        sqrt(variance / (double)n);
+    double const mean = fabs(s->Average());
+    *precision = (mean > 0.0) ? (width / mean) : 
+        ((width > 0.0) ? numeric_limits<double>::infinity() : 0.0);
+    return width;
+}
+
+// average number of cycles the sources of a class have fallen behind
+// their injection process
+double TrafficManager::_QueueLag( int c ) const
+{
+    double queue_lag = 0.0;
+    for(int s = 0; s < _nodes; ++s) {
+        queue_lag += (double)max(_time - _qtime[s][c], 0);
+    }
+    return queue_lag / (double)_nodes;
+}
+
 bool TrafficManager::_SingleSim( )
 {
     int converged = 0;
@@ -1423,18 +1917,71 @@ bool TrafficManager::_SingleSim( )
     vector<double> prev_accepted(_classes, 0.0);
     bool clear_last = false;
     int total_phases = 0;
+    // the confidence interval rule stops as soon as the precision is met
+    int const converge_periods = _ci_stopping ? 1 : 3;
+    vector<double> batch_latency(_classes);
+    vector<double> batch_count(_classes);
+    vector<double> batch_accepted(_classes);
+    vector<double> window_latency(_classes);
+    vector<double> window_count(_classes);
+    vector<vector<double> > mser_series(_classes);
+    vector<double> accepted_total(_classes, 0.0);
+    vector<deque<double> > in_flight_history(_classes);
+    vector<deque<double> > queue_lag_history(_classes);
+    vector<deque<double> > accepted_history(_classes);
+    if(_saturation_threshold >= 0.0) {
+        // start the source lag history with the state before the first 
+        // sample period, so it is checked as soon as saturation_periods 
+        // periods have been simulated; the in-flight count first has to 
+        // fill up to its steady level, so its history starts after one 
+        // period
+        for(int c = 0; c < _classes; ++c) {
+            queue_lag_history[c].push_back(_QueueLag(c));
+        }
+    }
     while( ( total_phases < _max_samples ) && 
            ( ( _sim_state != running ) || 
-             ( converged < 3 ) ) ) {
+             ( converged < converge_periods ) ) ) {
     
         if ( clear_last || (( ( _sim_state == warming_up ) && ( ( total_phases % 2 ) == 0 ) )) ) {
             clear_last = false;
             _ClearStats( );
         }
     
+        // batch boundaries, used by the confidence interval stopping rule
+        // and the saturation check only
+        if(_ci_stopping || (_saturation_threshold >= 0.0)) {
+            for(int c = 0; c < _classes; ++c) {
+                int total_accepted_count;
+                _ComputeStats( _accepted_flits[c], &total_accepted_count );
+                batch_latency[c] = _plat_stats[c]->Sum();
+                batch_count[c] = (double)_plat_stats[c]->NumSamples();
+                batch_accepted[c] = (double)total_accepted_count;
+            }
+        }
     
-        for ( int iter = 0; iter < _sample_period; ++iter )
+        for(int c = 0; c < _classes; ++c) {
+            window_latency[c] = _plat_stats[c]->Sum();
+            window_count[c] = (double)_plat_stats[c]->NumSamples();
+        }
+
+        for ( int iter = 0; iter < _sample_period; ++iter ) {
             _Step( );
+            if(_mser_warmup && (_sim_state == warming_up) && 
+               ((iter + 1) % _mser_window == 0)) {
+                _SyncRegions();
+                // record the mean latency of the packets retired in this window
+                for(int c = 0; c < _classes; ++c) {
+                    double const count = (double)_plat_stats[c]->NumSamples() - window_count[c];
+                    if(count > 0.0) {
+                        mser_series[c].push_back((_plat_stats[c]->Sum() - window_latency[c]) / count);
+                    }
+                    window_latency[c] = _plat_stats[c]->Sum();
+                    window_count[c] = (double)_plat_stats[c]->NumSamples();
+                }
+            }
+        }
+        _SyncRegions();
     
         //cout << _sim_state << endl;
 
@@ -1444,6 +1991,8 @@ bool TrafficManager::_SingleSim( )
         int lat_exc_class = -1;
         int lat_chg_exc_class = -1;
         int acc_chg_exc_class = -1;
+        int ci_exc_class = -1;
+        int sat_class = -1;
     
         for(int c = 0; c < _classes; ++c) {
       
@@ -1458,6 +2007,58 @@ bool TrafficManager::_SingleSim( )
             double total_accepted_rate = (double)total_accepted_count / (double)(_time - _reset_time);
             double cur_accepted = total_accepted_rate / (double)_nodes;
 
+            if(_saturation_threshold >= 0.0) {
+                // flits that have been generated but not received, and how 
+                // far the sources have fallen behind in generating packets; 
+                // both stay bounded unless the network is saturated
+                double const in_flight = (double)_total_in_flight_flits[c].size();
+                double const queue_lag = _QueueLag(c);
+                accepted_total[c] += (double)total_accepted_count - batch_accepted[c];
+                in_flight_history[c].push_back(in_flight);
+                queue_lag_history[c].push_back(queue_lag);
+                accepted_history[c].push_back(accepted_total[c]);
+                if((int)in_flight_history[c].size() > _saturation_periods) {
+                    double const in_flight_growth = (in_flight - in_flight_history[c].front()) / 
+                        max(accepted_total[c] - accepted_history[c].front(), 1.0);
+                    in_flight_history[c].pop_front();
+                    accepted_history[c].pop_front();
+                    if((sat_class < 0) && (in_flight_growth > _saturation_threshold)) {
+                        sat_class = c;
+                    }
+                }
+                if((int)queue_lag_history[c].size() > _saturation_periods) {
+                    double const queue_growth = (queue_lag - queue_lag_history[c].front()) / 
+                        ((double)_saturation_periods * (double)_sample_period);
+                    queue_lag_history[c].pop_front();
+                    if((sat_class < 0) && (queue_growth > _saturation_threshold)) {
+                        sat_class = c;
+                    }
+                }
+            }
+
+            if(_ci_stopping && (_sim_state == running)) {
+                // each sample period is one batch; packets that take longer 
+                // than a period to arrive are counted in a later batch
+                double const count = (double)_plat_stats[c]->NumSamples() - batch_count[c];
+                if(count > 0.0) {
+                    _plat_batch_stats[c]->AddSample((_plat_stats[c]->Sum() - batch_latency[c]) / count);
+                }
+                _accepted_batch_stats[c]->AddSample(((double)total_accepted_count - batch_accepted[c]) / 
+                                                    ((double)_sample_period * (double)_nodes));
+                double latency_precision, accepted_precision;
+                double latency_width = _ConfidenceInterval(_plat_batch_stats[c], &latency_precision);
+                double accepted_width = _ConfidenceInterval(_accepted_batch_stats[c], &accepted_precision);
+                cout << "latency CI        = " << _plat_batch_stats[c]->Average()
+                     << " +/- " << latency_width << endl;
+                cout << "throughput CI     = " << _accepted_batch_stats[c]->Average()
+                     << " +/- " << accepted_width << endl;
+                if((ci_exc_class < 0) &&
+                   ((_measure_latency && (latency_precision > _ci_precision)) ||
+                    (accepted_precision > _ci_precision))) {
+                    ci_exc_class = c;
+                }
+            }
+
             double latency_change = fabs((cur_latency - prev_latency[c]) / cur_latency);
             prev_latency[c] = cur_latency;
 
@@ -1514,6 +2115,21 @@ bool TrafficManager::_SingleSim( )
       
             cout << "Average latency for class " << lat_exc_class << " exceeded " << _latency_thres[lat_exc_class] << " cycles. Aborting simulation." << endl;
             converged = 0; 
+            _saturated = true;
+            _sim_state = draining;
+            _drain_time = _time;
+            if(_stats_out) {
+                WriteStats(*_stats_out);
+            }
+            break;
+      
+        }
+
+        if ( _measure_latency && ( sat_class >= 0 ) ) {
+      
+            cout << "Backlog for class " << sat_class << " grew over the last " << _saturation_periods << " sample periods. Aborting simulation." << endl;
+            converged = 0; 
+            _saturated = true;
             _sim_state = draining;
             _drain_time = _time;
             if(_stats_out) {
@@ -1524,17 +2140,41 @@ bool TrafficManager::_SingleSim( )
         }
     
         if ( _sim_state == warming_up ) {
-            if ( ( _warmup_periods > 0 ) ? 
-                 ( total_phases + 1 >= _warmup_periods ) :
-                 ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
-                   ( acc_chg_exc_class < 0 ) ) ) {
+            bool warmed_up;
+            if(_mser_warmup) {
+                // the transient is over once the MSER-5 truncation point of 
+                // every measured class lies in the first half of its series
+                warmed_up = true;
+                for(int c = 0; c < _classes; ++c) {
+                    if(_measure_stats[c] == 0) {
+                        continue;
+                    }
+                    int const truncation = _MserTruncation(mser_series[c]);
+                    cout << "MSER-5 truncation = ";
+                    if(truncation < 0) {
+                        cout << "none";
+                        warmed_up = false;
+                    } else {
+                        cout << truncation << " of " << mser_series[c].size() << " windows";
+                    }
+                    cout << endl;
+                }
+            } else {
+                warmed_up = ( _warmup_periods > 0 ) ? 
+                    ( total_phases + 1 >= _warmup_periods ) :
+                    ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
+                      ( acc_chg_exc_class < 0 ) );
+            }
+            if ( warmed_up ) {
                 cout << "Warmed up ..." <<  "Time used is " << _time << " cycles" <<endl;
                 clear_last = true;
                 _sim_state = running;
             }
         } else if(_sim_state == running) {
-            if ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
-                 ( acc_chg_exc_class < 0 ) ) {
+            if(_ci_stopping) {
+                converged = (ci_exc_class < 0) ? 1 : 0;
+            } else if ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
+                        ( acc_chg_exc_class < 0 ) ) {
                 ++converged;
             } else {
                 converged = 0;
@@ -1542,6 +2182,26 @@ bool TrafficManager::_SingleSim( )
         }
         ++total_phases;
     }
+
+    if(_ci_stopping && (_sim_state == running)) {
+        for(int c = 0; c < _classes; ++c) {
+            if(_measure_stats[c] == 0) {
+                continue;
+            }
+            double latency_precision, accepted_precision;
+            double latency_width = _ConfidenceInterval(_plat_batch_stats[c], &latency_precision);
+            double accepted_width = _ConfidenceInterval(_accepted_batch_stats[c], &accepted_precision);
+            cout << "Class " << c << " " << 100.0 * _ci_confidence 
+                 << "% confidence intervals after " 
+                 << _accepted_batch_stats[c]->NumSamples() << " batches:" << endl
+                 << "  packet latency = " << _plat_batch_stats[c]->Average()
+                 << " +/- " << latency_width 
+                 << " (" << 100.0 * latency_precision << "%)" << endl
+                 << "  accepted flit rate = " << _accepted_batch_stats[c]->Average()
+                 << " +/- " << accepted_width 
+                 << " (" << 100.0 * accepted_precision << "%)" << endl;
+        }
+    }
   
     if ( _sim_state == running ) {
         ++converged;
@@ -1589,6 +2249,7 @@ bool TrafficManager::_SingleSim( )
                     if(lat_exc_class >= 0) {
                         cout << "Average latency for class " << lat_exc_class << " exceeded " << _latency_thres[lat_exc_class] << " cycles. Aborting simulation." << endl;
                         converged = 0; 
+                        _saturated = true;
                         _sim_state = warming_up;
                         if(_stats_out) {
                             WriteStats(*_stats_out);
@@ -1610,9 +2271,18 @@ bool TrafficManager::_SingleSim( )
 
 bool TrafficManager::Run( )
 {
+    long long total_cycles = 0;
+    if(gProfile) {
+        _prof_flits = 0;
+        Profiler::Start();
+    }
+
     for ( int sim = 0; sim < _total_sims; ++sim ) {
 
         _time = 0;
+        _region_time = 0;
+        _RestoreLinkFaults( );
+        _next_link_fault = 0;
 
         //remove any pending request from the previous simulations
         _requestsOutstanding.assign(_nodes, 0);
@@ -1634,6 +2304,7 @@ bool TrafficManager::Run( )
         // converge
         // draing, wait until all packets finish
         _sim_state    = warming_up;
+        _saturated    = false;
   
         _ClearStats( );
 
@@ -1644,6 +2315,15 @@ bool TrafficManager::Run( )
 
         if ( !_SingleSim( ) ) {
             cout << "Simulation unstable, ending ..." << endl;
+            _SyncRegions();
+            if(_saturated && _print_csv_results) {
+                for(int c = 0; c < _classes; ++c) {
+                    cout << "results:" << c << ',' << _traffic[c]
+                         << ',' << _use_read_write[c]
+                         << ',' << _load[c]
+                         << ",saturated" << endl;
+                }
+            }
             return false;
         }
 
@@ -1680,6 +2360,7 @@ bool TrafficManager::Run( )
         //for the love of god don't ever say "Time taken" anywhere else
         //the power script depend on it
         cout << "Time taken is " << _time << " cycles" <<endl; 
+        total_cycles += _time;
 
         if(_stats_out) {
             WriteStats(*_stats_out);
@@ -1691,6 +2372,10 @@ bool TrafficManager::Run( )
     if(_print_csv_results) {
         DisplayOverallStatsCSV();
     }
+
+    if(gProfile) {
+        Profiler::Display(cout, total_cycles, _prof_flits);
+    }
   
     return true;
 }
@@ -1705,12 +2390,15 @@ void TrafficManager::_UpdateOverallStats() {
         _overall_min_plat[c] += _plat_stats[c]->Min();
         _overall_avg_plat[c] += _plat_stats[c]->Average();
         _overall_max_plat[c] += _plat_stats[c]->Max();
+        _overall_plat_stats[c]->Merge(*_plat_stats[c]);
         _overall_min_nlat[c] += _nlat_stats[c]->Min();
         _overall_avg_nlat[c] += _nlat_stats[c]->Average();
         _overall_max_nlat[c] += _nlat_stats[c]->Max();
+        _overall_nlat_stats[c]->Merge(*_nlat_stats[c]);
         _overall_min_flat[c] += _flat_stats[c]->Min();
         _overall_avg_flat[c] += _flat_stats[c]->Average();
         _overall_max_flat[c] += _flat_stats[c]->Max();
+        _overall_flat_stats[c]->Merge(*_flat_stats[c]);
     
         _overall_min_frag[c] += _frag_stats[c]->Min();
         _overall_avg_frag[c] += _frag_stats[c]->Average();
@@ -1755,28 +2443,28 @@ void TrafficManager::_UpdateOverallStats() {
         _overall_avg_accepted_packets[c] += rate_avg;
         _overall_max_accepted_packets[c] += rate_max;
 
-#ifdef TRACK_STALLS
-        _ComputeStats(_buffer_busy_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        _overall_buffer_busy_stalls[c] += rate_avg;
-        _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        _overall_buffer_conflict_stalls[c] += rate_avg;
-        _ComputeStats(_buffer_full_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        _overall_buffer_full_stalls[c] += rate_avg;
-        _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        _overall_buffer_reserved_stalls[c] += rate_avg;
-        _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        _overall_crossbar_conflict_stalls[c] += rate_avg;
-#endif
+        if(_track_stalls) {
+            _ComputeStats(_buffer_busy_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            _overall_buffer_busy_stalls[c] += rate_avg;
+            _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            _overall_buffer_conflict_stalls[c] += rate_avg;
+            _ComputeStats(_buffer_full_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            _overall_buffer_full_stalls[c] += rate_avg;
+            _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            _overall_buffer_reserved_stalls[c] += rate_avg;
+            _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            _overall_crossbar_conflict_stalls[c] += rate_avg;
+        }
 
     }
 }
@@ -1794,38 +2482,54 @@ void TrafficManager::WriteStats(ostream & os) const {
         //c+1 due to matlab array starting at 1
         os << "plat(" << c+1 << ") = " << _plat_stats[c]->Average() << ";" << endl
            << "plat_hist(" << c+1 << ",:) = " << *_plat_stats[c] << ";" << endl
+           << "plat_pct(" << c+1 << ",:) = [ " << _plat_stats[c]->Quantile(0.5) 
+           << " " << _plat_stats[c]->Quantile(0.99) 
+           << " " << _plat_stats[c]->Quantile(0.999) << " ];" << endl
            << "nlat(" << c+1 << ") = " << _nlat_stats[c]->Average() << ";" << endl
            << "nlat_hist(" << c+1 << ",:) = " << *_nlat_stats[c] << ";" << endl
+           << "nlat_pct(" << c+1 << ",:) = [ " << _nlat_stats[c]->Quantile(0.5) 
+           << " " << _nlat_stats[c]->Quantile(0.99) 
+           << " " << _nlat_stats[c]->Quantile(0.999) << " ];" << endl
            << "flat(" << c+1 << ") = " << _flat_stats[c]->Average() << ";" << endl
            << "flat_hist(" << c+1 << ",:) = " << *_flat_stats[c] << ";" << endl
+           << "flat_pct(" << c+1 << ",:) = [ " << _flat_stats[c]->Quantile(0.5) 
+           << " " << _flat_stats[c]->Quantile(0.99) 
+           << " " << _flat_stats[c]->Quantile(0.999) << " ];" << endl
            << "frag_hist(" << c+1 << ",:) = " << *_frag_stats[c] << ";" << endl
            << "hops(" << c+1 << ",:) = " << *_hop_stats[c] << ";" << endl;
         if(_pair_stats){
             os<< "pair_sent(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_plat[c][i*_nodes+j]->NumSamples() << " ";
+                    os << _pair_plat[c]->NumSamples(i, j) << " ";
                 }
             }
             os << "];" << endl
                << "pair_plat(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_plat[c][i*_nodes+j]->Average( ) << " ";
+                    os << _pair_plat[c]->Average(i, j) << " ";
+                }
+            }
+            os << "];" << endl
+               << "pair_plat_p99(" << c+1 << ",:) = [ ";
+            for(int i = 0; i < _nodes; ++i) {
+                for(int j = 0; j < _nodes; ++j) {
+                    os << _pair_plat[c]->Quantile(i, j, 0.99) << " ";
                 }
             }
             os << "];" << endl
                << "pair_nlat(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_nlat[c][i*_nodes+j]->Average( ) << " ";
+                    os << _pair_nlat[c]->Average(i, j) << " ";
                 }
             }
             os << "];" << endl
                << "pair_flat(" << c+1 << ",:) = [ ";
             for(int i = 0; i < _nodes; ++i) {
                 for(int j = 0; j < _nodes; ++j) {
-                    os << _pair_flat[c][i*_nodes+j]->Average( ) << " ";
+                    os << _pair_flat[c]->Average(i, j) << " ";
                 }
             }
         }
@@ -1863,110 +2567,108 @@ void TrafficManager::WriteStats(ostream & os) const {
             os << (double)_accepted_flits[c][d] / (double)_accepted_packets[c][d] << " ";
         }
         os << "];" << endl;
-#ifdef TRACK_STALLS
-        os << "buffer_busy_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_busy_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-           << "buffer_conflict_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_conflict_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-           << "buffer_full_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_full_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-           << "buffer_reserved_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_reserved_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-           << "crossbar_conflict_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_crossbar_conflict_stalls[c][d] / time_delta << " ";
+        if(_track_stalls) {
+            os << "buffer_busy_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_busy_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+               << "buffer_conflict_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_conflict_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+               << "buffer_full_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_full_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+               << "buffer_reserved_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_reserved_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+               << "crossbar_conflict_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_crossbar_conflict_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl;
         }
-        os << "];" << endl;
-#endif
     }
 }
 
 void TrafficManager::UpdateStats() {
-#if defined(TRACK_FLOWS) || defined(TRACK_STALLS)
-    for(int c = 0; c < _classes; ++c) {
-#ifdef TRACK_FLOWS
-        {
-            char trail_char = (c == _classes - 1) ? '\n' : ',';
-            if(_injected_flits_out) *_injected_flits_out << _injected_flits[c] << trail_char;
-            _injected_flits[c].assign(_nodes, 0);
-            if(_ejected_flits_out) *_ejected_flits_out << _ejected_flits[c] << trail_char;
-            _ejected_flits[c].assign(_nodes, 0);
-        }
-#endif
-        for(int subnet = 0; subnet < _subnets; ++subnet) {
-#ifdef TRACK_FLOWS
-            if(_outstanding_credits_out) *_outstanding_credits_out << _outstanding_credits[c][subnet] << ',';
-            if(_stored_flits_out) *_stored_flits_out << vector<int>(_nodes, 0) << ',';
-#endif
-            for(int router = 0; router < _routers; ++router) {
-                Router * const r = _router[subnet][router];
-#ifdef TRACK_FLOWS
-                char trail_char = 
-                    ((router == _routers - 1) && (subnet == _subnets - 1) && (c == _classes - 1)) ? '\n' : ',';
-                if(_received_flits_out) *_received_flits_out << r->GetReceivedFlits(c) << trail_char;
-                if(_stored_flits_out) *_stored_flits_out << r->GetStoredFlits(c) << trail_char;
-                if(_sent_flits_out) *_sent_flits_out << r->GetSentFlits(c) << trail_char;
-                if(_outstanding_credits_out) *_outstanding_credits_out << r->GetOutstandingCredits(c) << trail_char;
-                if(_active_packets_out) *_active_packets_out << r->GetActivePackets(c) << trail_char;
-                r->ResetFlowStats(c);
-#endif
-#ifdef TRACK_STALLS
-                _buffer_busy_stalls[c][subnet*_routers+router] += r->GetBufferBusyStalls(c);
-                _buffer_conflict_stalls[c][subnet*_routers+router] += r->GetBufferConflictStalls(c);
-                _buffer_full_stalls[c][subnet*_routers+router] += r->GetBufferFullStalls(c);
-                _buffer_reserved_stalls[c][subnet*_routers+router] += r->GetBufferReservedStalls(c);
-                _crossbar_conflict_stalls[c][subnet*_routers+router] += r->GetCrossbarConflictStalls(c);
-                r->ResetStallStats(c);
-#endif
+    if(_track_flows || _track_stalls) {
+        for(int c = 0; c < _classes; ++c) {
+            if(_track_flows) {
+                char trail_char = (c == _classes - 1) ? '\n' : ',';
+                if(_injected_flits_out) *_injected_flits_out << _injected_flits.Row(c) << trail_char;
+                _injected_flits.Reset(c);
+                if(_ejected_flits_out) *_ejected_flits_out << _ejected_flits.Row(c) << trail_char;
+                _ejected_flits.Reset(c);
+            }
+            for(int subnet = 0; subnet < _subnets; ++subnet) {
+                if(_track_flows) {
+                    if(_outstanding_credits_out) *_outstanding_credits_out << _outstanding_credits[c][subnet] << ',';
+                    if(_stored_flits_out) *_stored_flits_out << vector<int>(_nodes, 0) << ',';
+                }
+                for(int router = 0; router < _routers; ++router) {
+                    Router * const r = _router[subnet][router];
+                    if(_track_flows) {
+                        char trail_char = 
+                            ((router == _routers - 1) && (subnet == _subnets - 1) && (c == _classes - 1)) ? '\n' : ',';
+                        if(_received_flits_out) *_received_flits_out << r->GetReceivedFlits(c) << trail_char;
+                        if(_stored_flits_out) *_stored_flits_out << r->GetStoredFlits(c) << trail_char;
+                        if(_sent_flits_out) *_sent_flits_out << r->GetSentFlits(c) << trail_char;
+                        if(_outstanding_credits_out) *_outstanding_credits_out << r->GetOutstandingCredits(c) << trail_char;
+                        if(_active_packets_out) *_active_packets_out << r->GetActivePackets(c) << trail_char;
+                        r->ResetFlowStats(c);
+                    }
+                    if(_track_stalls) {
+                        _buffer_busy_stalls[c][subnet*_routers+router] += r->GetBufferBusyStalls(c);
+                        _buffer_conflict_stalls[c][subnet*_routers+router] += r->GetBufferConflictStalls(c);
+                        _buffer_full_stalls[c][subnet*_routers+router] += r->GetBufferFullStalls(c);
+                        _buffer_reserved_stalls[c][subnet*_routers+router] += r->GetBufferReservedStalls(c);
+                        _crossbar_conflict_stalls[c][subnet*_routers+router] += r->GetCrossbarConflictStalls(c);
+                        r->ResetStallStats(c);
+                    }
+                }
             }
         }
     }
-#ifdef TRACK_FLOWS
-    if(_injected_flits_out) *_injected_flits_out << flush;
-    if(_received_flits_out) *_received_flits_out << flush;
-    if(_stored_flits_out) *_stored_flits_out << flush;
-    if(_sent_flits_out) *_sent_flits_out << flush;
-    if(_outstanding_credits_out) *_outstanding_credits_out << flush;
-    if(_ejected_flits_out) *_ejected_flits_out << flush;
-    if(_active_packets_out) *_active_packets_out << flush;
-#endif
-#endif
-
-#ifdef TRACK_CREDITS
-    for(int s = 0; s < _subnets; ++s) {
-        for(int n = 0; n < _nodes; ++n) {
-            BufferState const * const bs = _buf_states[n][s];
-            for(int v = 0; v < _vcs; ++v) {
-                if(_used_credits_out) *_used_credits_out << bs->OccupancyFor(v) << ',';
-                if(_free_credits_out) *_free_credits_out << bs->AvailableFor(v) << ',';
-                if(_max_credits_out) *_max_credits_out << bs->LimitFor(v) << ',';
+    if(_track_flows) {
+        if(_injected_flits_out) *_injected_flits_out << flush;
+        if(_received_flits_out) *_received_flits_out << flush;
+        if(_stored_flits_out) *_stored_flits_out << flush;
+        if(_sent_flits_out) *_sent_flits_out << flush;
+        if(_outstanding_credits_out) *_outstanding_credits_out << flush;
+        if(_ejected_flits_out) *_ejected_flits_out << flush;
+        if(_active_packets_out) *_active_packets_out << flush;
+    }
+
+    if(_track_credits) {
+        for(int s = 0; s < _subnets; ++s) {
+            for(int n = 0; n < _nodes; ++n) {
+                BufferState const * const bs = _buf_states[n][s];
+                for(int v = 0; v < _vcs; ++v) {
+                    if(_used_credits_out) *_used_credits_out << bs->OccupancyFor(v) << ',';
+                    if(_free_credits_out) *_free_credits_out << bs->AvailableFor(v) << ',';
+                    if(_max_credits_out) *_max_credits_out << bs->LimitFor(v) << ',';
+                }
+            }
+            for(int r = 0; r < _routers; ++r) {
+                Router const * const rtr = _router[s][r];
+                char trail_char = 
+                    ((r == _routers - 1) && (s == _subnets - 1)) ? '\n' : ',';
+                if(_used_credits_out) *_used_credits_out << rtr->UsedCredits() << trail_char;
+                if(_free_credits_out) *_free_credits_out << rtr->FreeCredits() << trail_char;
+                if(_max_credits_out) *_max_credits_out << rtr->MaxCredits() << trail_char;
             }
         }
-        for(int r = 0; r < _routers; ++r) {
-            Router const * const rtr = _router[s][r];
-            char trail_char = 
-                ((r == _routers - 1) && (s == _subnets - 1)) ? '\n' : ',';
-            if(_used_credits_out) *_used_credits_out << rtr->UsedCredits() << trail_char;
-            if(_free_credits_out) *_free_credits_out << rtr->FreeCredits() << trail_char;
-            if(_max_credits_out) *_max_credits_out << rtr->MaxCredits() << trail_char;
-        }
+        if(_used_credits_out) *_used_credits_out << flush;
+        if(_free_credits_out) *_free_credits_out << flush;
+        if(_max_credits_out) *_max_credits_out << flush;
     }
-    if(_used_credits_out) *_used_credits_out << flush;
-    if(_free_credits_out) *_free_credits_out << flush;
-    if(_max_credits_out) *_max_credits_out << flush;
-#endif
 
 }
 
@@ -2054,28 +2756,28 @@ void TrafficManager::DisplayStats(ostream & os) const {
              << " (" << _measured_in_flight_flits[c].size() << " measured)"
              << endl;
     
-#ifdef TRACK_STALLS
-        _ComputeStats(_buffer_busy_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer busy stall rate = " << rate_avg << endl;
-        _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer conflict stall rate = " << rate_avg << endl;
-        _ComputeStats(_buffer_full_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer full stall rate = " << rate_avg << endl;
-        _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer reserved stall rate = " << rate_avg << endl;
-        _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Crossbar conflict stall rate = " << rate_avg << endl;
-#endif
+        if(_track_stalls) {
+            _ComputeStats(_buffer_busy_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer busy stall rate = " << rate_avg << endl;
+            _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer conflict stall rate = " << rate_avg << endl;
+            _ComputeStats(_buffer_full_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer full stall rate = " << rate_avg << endl;
+            _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer reserved stall rate = " << rate_avg << endl;
+            _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Crossbar conflict stall rate = " << rate_avg << endl;
+        }
     
     }
 }
@@ -2097,6 +2799,9 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
            << " (" << _total_sims << " samples)" << endl;
         os << "\tmaximum = " << _overall_max_plat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
+        os << "\t50th percentile = " << _overall_plat_stats[c]->Quantile(0.5) << endl;
+        os << "\t99th percentile = " << _overall_plat_stats[c]->Quantile(0.99) << endl;
+        os << "\t99.9th percentile = " << _overall_plat_stats[c]->Quantile(0.999) << endl;
 
         os << "Network latency average = " << _overall_avg_nlat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
@@ -2104,6 +2809,9 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
            << " (" << _total_sims << " samples)" << endl;
         os << "\tmaximum = " << _overall_max_nlat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
+        os << "\t50th percentile = " << _overall_nlat_stats[c]->Quantile(0.5) << endl;
+        os << "\t99th percentile = " << _overall_nlat_stats[c]->Quantile(0.99) << endl;
+        os << "\t99.9th percentile = " << _overall_nlat_stats[c]->Quantile(0.999) << endl;
 
         os << "Flit latency average = " << _overall_avg_flat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
@@ -2111,6 +2819,9 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
            << " (" << _total_sims << " samples)" << endl;
         os << "\tmaximum = " << _overall_max_flat[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
+        os << "\t50th percentile = " << _overall_flat_stats[c]->Quantile(0.5) << endl;
+        os << "\t99th percentile = " << _overall_flat_stats[c]->Quantile(0.99) << endl;
+        os << "\t99.9th percentile = " << _overall_flat_stats[c]->Quantile(0.999) << endl;
 
         os << "Fragmentation average = " << _overall_avg_frag[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
@@ -2156,18 +2867,18 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
         os << "Hops average = " << _overall_hop_stats[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
     
-#ifdef TRACK_STALLS
-        os << "Buffer busy stall rate = " << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
-           << " (" << _total_sims << " samples)" << endl
-           << "Buffer conflict stall rate = " << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
-           << " (" << _total_sims << " samples)" << endl
-           << "Buffer full stall rate = " << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
-           << " (" << _total_sims << " samples)" << endl
-           << "Buffer reserved stall rate = " << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
-           << " (" << _total_sims << " samples)" << endl
-           << "Crossbar conflict stall rate = " << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims
-           << " (" << _total_sims << " samples)" << endl;
-#endif
+        if(_track_stalls) {
+            os << "Buffer busy stall rate = " << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
+               << " (" << _total_sims << " samples)" << endl
+               << "Buffer conflict stall rate = " << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
+               << " (" << _total_sims << " samples)" << endl
+               << "Buffer full stall rate = " << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
+               << " (" << _total_sims << " samples)" << endl
+               << "Buffer reserved stall rate = " << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
+               << " (" << _total_sims << " samples)" << endl
+               << "Crossbar conflict stall rate = " << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims
+               << " (" << _total_sims << " samples)" << endl;
+        }
     
     }
   
@@ -2205,15 +2916,24 @@ string TrafficManager::_OverallStatsCSV(int c) const
        << ',' << _overall_max_accepted[c] / (double)_total_sims
        << ',' << _overall_avg_sent[c] / _overall_avg_sent_packets[c]
        << ',' << _overall_avg_accepted[c] / _overall_avg_accepted_packets[c]
-       << ',' << _overall_hop_stats[c] / (double)_total_sims;
-
-#ifdef TRACK_STALLS
-    os << ',' << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
-       << ',' << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
-       << ',' << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
-       << ',' << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
-       << ',' << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims;
-#endif
+       << ',' << _overall_hop_stats[c] / (double)_total_sims
+       << ',' << _overall_plat_stats[c]->Quantile(0.5)
+       << ',' << _overall_plat_stats[c]->Quantile(0.99)
+       << ',' << _overall_plat_stats[c]->Quantile(0.999)
+       << ',' << _overall_nlat_stats[c]->Quantile(0.5)
+       << ',' << _overall_nlat_stats[c]->Quantile(0.99)
+       << ',' << _overall_nlat_stats[c]->Quantile(0.999)
+       << ',' << _overall_flat_stats[c]->Quantile(0.5)
+       << ',' << _overall_flat_stats[c]->Quantile(0.99)
+       << ',' << _overall_flat_stats[c]->Quantile(0.999);
+
+    if(_track_stalls) {
+        os << ',' << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
+           << ',' << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
+           << ',' << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
+           << ',' << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
+           << ',' << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims;
+    }
 
     return os.str();
 }
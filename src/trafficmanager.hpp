@@ -39,16 +39,24 @@
 #include "flit.hpp"
 #include "buffer_state.hpp"
 #include "stats.hpp"
+#include "pair_stats.hpp"
 #include "traffic.hpp"
 #include "routefunc.hpp"
 #include "outputset.hpp"
 #include "injection.hpp"
+#include "packet_trace.hpp"
+#include "channel_sampler.hpp"
+#include "power_module.hpp"
 
 //register the requests to a node
 class PacketReplyInfo;
+class ParallelEngine;
 
 class TrafficManager : public Module {
 
+  // runs the terminals of each region (_StepRegion)
+  friend class ParallelEngine;
+
 private:
 
   vector<vector<int> > _packet_size;
@@ -95,10 +103,14 @@ protected:
   // ============ Injection VC states  ============ 
 
   vector<vector<BufferState *> > _buf_states;
-#ifdef TRACK_FLOWS
+  // optional instrumentation, selected with track_flows, track_stalls 
+  // and track_credits
+  bool _track_flows;
+  bool _track_stalls;
+  bool _track_credits;
+
   vector<vector<vector<int> > > _outstanding_credits;
   vector<vector<vector<queue<int> > > > _outstanding_classes;
-#endif
   vector<vector<vector<int> > > _last_vc;
 
   // ============ Routing ============ 
@@ -106,6 +118,10 @@ protected:
   tRoutingFunction _rf;
   bool _lookahead_routing;
   bool _noq;
+  // routers draw from random streams of their own (Network::SeedRandomStreams)
+  // and so do the terminals, from _node_random
+  bool _random_streams;
+  vector<unsigned long long> _node_random;
 
   // ============ Injection queues ============ 
 
@@ -116,6 +132,8 @@ protected:
   vector<map<int, Flit *> > _total_in_flight_flits;
   vector<map<int, Flit *> > _measured_in_flight_flits;
   vector<map<int, Flit *> > _retired_packets;
+  // flit read from each node's ejection channel in this cycle, by subnet
+  vector<vector<Flit *> > _ejected;
   bool _empty_network;
 
   bool _hold_switch_for_packet;
@@ -143,25 +161,32 @@ protected:
   vector<double> _overall_min_plat;  
   vector<double> _overall_avg_plat;  
   vector<double> _overall_max_plat;  
+  vector<Stats *> _overall_plat_stats;
 
   vector<Stats *> _nlat_stats;     
   vector<double> _overall_min_nlat;  
   vector<double> _overall_avg_nlat;  
   vector<double> _overall_max_nlat;  
+  vector<Stats *> _overall_nlat_stats;
 
   vector<Stats *> _flat_stats;     
   vector<double> _overall_min_flat;  
   vector<double> _overall_avg_flat;  
   vector<double> _overall_max_flat;  
+  vector<Stats *> _overall_flat_stats;
 
   vector<Stats *> _frag_stats;
   vector<double> _overall_min_frag;
   vector<double> _overall_avg_frag;
   vector<double> _overall_max_frag;
 
-  vector<vector<Stats *> > _pair_plat;
-  vector<vector<Stats *> > _pair_nlat;
-  vector<vector<Stats *> > _pair_flat;
+  // per-sample-period means of latency and accepted flit rate
+  vector<Stats *> _plat_batch_stats;
+  vector<Stats *> _accepted_batch_stats;
+
+  vector<PairStats *> _pair_plat;
+  vector<PairStats *> _pair_nlat;
+  vector<PairStats *> _pair_flat;
 
   vector<Stats *> _hop_stats;
   vector<double> _overall_hop_stats;
@@ -183,7 +208,6 @@ protected:
   vector<double> _overall_avg_accepted;
   vector<double> _overall_max_accepted;
 
-#ifdef TRACK_STALLS
   vector<vector<int> > _buffer_busy_stalls;
   vector<vector<int> > _buffer_conflict_stalls;
   vector<vector<int> > _buffer_full_stalls;
@@ -194,7 +218,6 @@ protected:
   vector<double> _overall_buffer_full_stalls;
   vector<double> _overall_buffer_reserved_stalls;
   vector<double> _overall_crossbar_conflict_stalls;
-#endif
 
   vector<int> _slowest_packet;
   vector<int> _slowest_flit;
@@ -220,6 +243,7 @@ protected:
 
   vector<int> _measure_stats;
   bool _pair_stats;
+  bool _sparse_pair_stats;
 
   vector<double> _latency_thres;
 
@@ -229,6 +253,35 @@ protected:
   vector<double> _warmup_threshold;
   vector<double> _acc_warmup_threshold;
 
+  // batch means stopping rule: stop once the confidence intervals of 
+  // latency and throughput are within _ci_precision of their means
+  bool _ci_stopping;
+  double _ci_precision;
+  double _ci_confidence;
+  int _ci_min_batches;
+
+  // MSER-5 warm-up detection over per-window latency means
+  bool _mser_warmup;
+  int _mser_window;
+  int _mser_min_batches;
+
+  // abort latency simulations once the backlog of generated but undelivered 
+  // flits, or the lag of the sources behind the injection process, grows 
+  // by more than _saturation_threshold over _saturation_periods periods
+  double _saturation_threshold;
+  int _saturation_periods;
+  bool _saturated;
+
+  // self-profiler stage ids
+  int _prof_eject;
+  int _prof_read_inputs;
+  int _prof_inject;
+  int _prof_inject_flits;
+  int _prof_retire;
+  int _prof_evaluate;
+  int _prof_write_outputs;
+  long long _prof_flits;
+
   int _cur_id;
   int _cur_pid;
   int _time;
@@ -241,9 +294,40 @@ protected:
   //flits to watch
   ostream * _stats_out;
 
-#ifdef TRACK_FLOWS
-  vector<vector<int> > _injected_flits;
-  vector<vector<int> > _ejected_flits;
+  // packet capture for later replay with sim_type = trace
+  TraceWriter * _trace_out;
+
+  // periodic channel and buffer utilization samples
+  ChannelSampler * _util_sampler;
+  int _util_sample_period;
+
+  // runs the routers and their terminals on threads of their own when
+  // parallel_regions > 0
+  ParallelEngine * _engine;
+  vector<vector<int> > _region_nodes;
+  // packets the regions generated and flits they ejected, by node and 
+  // with the cycle; the main thread numbers and retires them when it 
+  // syncs with the regions, and has done so for the cycles before 
+  // _region_time
+  vector<vector<pair<int, Flit *> > > _region_generated;
+  vector<vector<pair<int, Flit *> > > _region_ejected;
+  int _region_time;
+
+  // per-subnet energy accounted in fixed epochs during the simulation
+  vector<Power_Module *> _power_epochs;
+  int _power_epoch_period;
+  ostream * _power_epoch_out;
+
+  // scheduled link failures and repairs, as {cycle, router, port, fail}
+  // sorted by cycle, and the next one to apply
+  vector<vector<int> > _link_faults;
+  size_t _next_link_fault;
+  // state of each scheduled link before the schedule first changed it,
+  // restored before the next simulation replays the schedule
+  map<pair<int, int>, bool> _link_fault_initial;
+
+  ClassCounters _injected_flits;
+  ClassCounters _ejected_flits;
   ostream * _injected_flits_out;
   ostream * _received_flits_out;
   ostream * _stored_flits_out;
@@ -251,31 +335,47 @@ protected:
   ostream * _outstanding_credits_out;
   ostream * _ejected_flits_out;
   ostream * _active_packets_out;
-#endif
 
-#ifdef TRACK_CREDITS
   ostream * _used_credits_out;
   ostream * _free_credits_out;
   ostream * _max_credits_out;
-#endif
 
   // ============ Internal methods ============ 
 protected:
 
   virtual void _RetireFlit( Flit *f, int dest );
 
-  void _Inject();
+  virtual void _Inject();
   void _Step( );
 
+  // one node's share of a cycle, in the order _Step runs them
+  Flit * _ReadNode( int subnet, int n );
+  void _InjectNode( int input, int time );
+  void _SendNode( int subnet, int n, int time );
+  void _AcceptNode( int subnet, int n, int time );
+  void _QueueReply( Flit const * f, int dest );
+
+  // the terminals of one region for the parallel engine, and the main
+  // thread's side of a sync with the regions
+  void _StepRegion( int region, int time );
+  void _SyncRegions( );
+
   bool _PacketsOutstanding( ) const;
   
-  virtual int  _IssuePacket( int source, int cl );
+  virtual int  _IssuePacket( int source, int cl, int time );
   void _GeneratePacket( int source, int size, int cl, int time );
+  int  _EnqueuePacket( int source, int dest, int size, int cl, int time,
+                       Flit::FlitType type, bool record, int dep = -1 );
 
   virtual void _ClearStats( );
+  void _RestoreLinkFaults( );
 
   void _ComputeStats( const vector<int> & stats, int *sum, int *min = NULL, int *max = NULL, int *min_pos = NULL, int *max_pos = NULL ) const;
 
+  int _MserTruncation( vector<double> const & series ) const;
+  double _ConfidenceInterval( Stats const * s, double * precision ) const;
+  double _QueueLag( int c ) const;
+
   virtual bool _SingleSim( );
 
   void _DisplayRemaining( ostream & os = cout ) const;
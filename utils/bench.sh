@@ -0,0 +1,169 @@
+#!/bin/sh
+
+# $Id$
+
+# Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# Redistributions of source code must retain the above copyright notice, this
+# list of conditions and the following disclaimer.
+# Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+
+# This is a helper script that runs a fixed benchmark suite to track the 
+# speed of the simulator itself.
+#
+# It takes the simulator executable and, optionally, a baseline file 
+# produced by an earlier run as its parameters.
+#
+# Example:
+#
+#  ./bench.sh ./booksim bench_baseline.json
+#
+# Each configuration in the suite is run with a pinned seed, a single 
+# simulation, the 'change' warm-up and stopping rules with a fixed number of 
+# warm-up periods and stopping thresholds disabled, so that every run 
+# simulates a fixed number of sample periods; only the final drain varies 
+# slightly in length.  BookSim's 'profile' parameter is enabled and its 
+# summary is collected into a JSON file (bench.json by default, see 
+# bench_out), one benchmark per line, with the speed taken from the number
+# of cycles each run reports.  If a baseline is given, the simulated 
+# cycles per second of each benchmark are compared against it 
+# and the script exits with a non-zero status if any benchmark is slower 
+# than the baseline by more than bench_tolerance.  Status information is 
+# printed in lines that begin with "BENCH: ".
+
+if [ "${1}" = "" ]
+then
+    echo "BENCH: Please specify a simulator executable as the first parameter."
+    exit 1
+fi
+
+sim=`cd \`dirname ${1}\` && pwd`/`basename ${1}`
+baseline=${2}
+
+if [ "${bench_out}" = "" ]
+then
+    bench_out=bench.json
+fi
+if [ "${bench_period}" = "" ]
+then
+    bench_period=2000
+fi
+if [ "${bench_tolerance}" = "" ]
+then
+    bench_tolerance=0.10
+fi
+if [ "${bench_examples}" = "" ]
+then
+    bench_examples=`dirname ${0}`/../src/examples
+fi
+examples=`cd ${bench_examples} && pwd`
+
+suite="mesh88_lat torus88 cmeshconfig dragonflyconfig flatflyconfig fattree_config anynet/anynet_config"
+
+fixed="seed=0 sim_count=1 sample_period=${bench_period} warmup_periods=3 max_samples=10 warmup_rule=change stopping_rule=change stopping_thres=-1.0 acc_stopping_thres=-1.0 profile=1"
+
+# per-benchmark overrides; the 1056-node dragonfly is run at a lower load 
+# and for a quarter of the cycles to keep the suite's run time reasonable
+extra() {
+    case ${1} in
+	dragonflyconfig)
+	    echo "injection_rate=0.1 sample_period=`expr ${bench_period} / 4`"
+	    ;;
+    esac
+}
+
+# extracts the value of a "Name = value" line from the profile summary
+field() {
+    grep "^${1} = " ${log} | tail -n 1 | sed -e 's/^[^=]*= *//' -e 's/ .*$//'
+}
+
+log=${bench_out}.${$}.log
+failed=0
+
+echo "{" > ${bench_out}
+echo "  \"period\": ${bench_period}," >> ${bench_out}
+echo "  \"benchmarks\": [" >> ${bench_out}
+sep=""
+for config in ${suite}
+do
+    name=`basename ${config}`
+    echo "BENCH: Running ${name}..."
+    # run from the configuration's directory so that relative file names
+    # (e.g. anynet's network_file) resolve
+    ( cd ${examples}/`dirname ${config}` && ${sim} ${name} ${fixed} `extra ${name}` ) > ${log} 2>&1
+    cycles=`field "Simulated cycles"`
+    if [ "${cycles}" = "" ]
+    then
+	echo "BENCH: Simulation run failed."
+	failed=1
+	continue
+    fi
+    wall=`field "Wall time"`
+    cps=`field "Cycles per second"`
+    flits=`field "Delivered flits"`
+    fps=`field "Flits per second"`
+    rss=`field "Peak RSS"`
+    echo "BENCH: ${name}: ${cycles} cycles in ${wall} s, ${cps} cycles/s, ${fps} flits/s, ${rss} kB peak RSS"
+    printf '%s    { "name": "%s", "cycles": %s, "wall_seconds": %s, "cycles_per_second": %s, "flits": %s, "flits_per_second": %s, "peak_rss_kb": %s }' \
+	"${sep}" ${name} ${cycles} ${wall} ${cps} ${flits} ${fps} ${rss} >> ${bench_out}
+    sep=",
+"
+done
+echo "" >> ${bench_out}
+echo "  ]" >> ${bench_out}
+echo "}" >> ${bench_out}
+rm -f ${log}
+
+echo "BENCH: Results written to ${bench_out}."
+
+if [ "${baseline}" = "" ]
+then
+    exit ${failed}
+fi
+if [ ! -f "${baseline}" ]
+then
+    echo "BENCH: Baseline ${baseline} not found; skipping comparison."
+    exit ${failed}
+fi
+
+echo "BENCH: Comparing against ${baseline} (tolerance ${bench_tolerance})..."
+for config in ${suite}
+do
+    name=`basename ${config}`
+    new=`grep "\"name\": \"${name}\"" ${bench_out} | sed -e 's/.*"cycles_per_second": *\([^,]*\),.*/\1/'`
+    old=`grep "\"name\": \"${name}\"" ${baseline} | sed -e 's/.*"cycles_per_second": *\([^,]*\),.*/\1/'`
+    if [ "${new}" = "" ] || [ "${old}" = "" ]
+    then
+	echo "BENCH: ${name}: no result to compare."
+	continue
+    fi
+    ratio=`awk -v n=${new} -v o=${old} 'BEGIN{ printf "%.3f", n / o }'`
+    if [ "`awk -v r=${ratio} -v t=${bench_tolerance} 'BEGIN{ print ( r < 1.0 - t ) }'`" = "1" ]
+    then
+	echo "BENCH: ${name}: ${ratio}x baseline speed (REGRESSION)"
+	failed=1
+    else
+	echo "BENCH: ${name}: ${ratio}x baseline speed"
+    fi
+done
+
+exit ${failed}
@@ -0,0 +1,211 @@
+// $Id$
+
+/*
+ Copyright (c) 2007-2015, Trustees of The Leland Stanford Junior University
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this 
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*event2json.cpp
+ *
+ *Converts a binary event trace written with the event_trace option into
+ *Chrome trace event JSON, which can be loaded into chrome://tracing or 
+ *Perfetto (ui.perfetto.dev).  One simulated cycle is shown as one
+ *microsecond.
+ *
+ *Routers and terminal nodes appear as processes.  Router events are 
+ *placed on one track per input port, link traversals on one track per
+ *output port, and each flit is an async slice from injection to ejection.
+ *
+ *Build: g++ -O2 -I../src -o event2json event2json.cpp
+ *Usage: event2json trace.bin [out.json]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <utility>
+
+#include "event_trace.hpp"
+
+using namespace std;
+
+// process id offset for terminal nodes, so they don't collide with routers
+static int const NODE_PID = 1000000;
+// thread id offsets for output port and injection channel tracks
+static int const OUT_TID = 10000;
+static int const INJECT_TID = 20000;
+
+static char const * const event_names[EventTrace::NUM_EVENT_TYPES] = 
+  { "inject", "route", "vc_grant", "sw_grant", "link", "eject" };
+
+static set<int> processes;
+static set<pair<int, int> > threads;
+static bool first = true;
+
+static void _Begin( FILE * out )
+{
+  fputs(first ? "\n" : ",\n", out);
+  first = false;
+}
+
+static void _Track( FILE * out, int pid, int tid )
+{
+  if(processes.insert(pid).second) {
+    _Begin(out);
+    if(pid >= NODE_PID) {
+      fprintf(out, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,"
+	      "\"args\":{\"name\":\"node %d\"}}", pid, pid - NODE_PID);
+    } else {
+      fprintf(out, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,"
+	      "\"args\":{\"name\":\"router %d\"}}", pid, pid);
+    }
+  }
+  if(threads.insert(make_pair(pid, tid)).second) {
+    char name[32];
+    if(pid >= NODE_PID) {
+      sprintf(name, "flits");
+    } else if(tid >= INJECT_TID) {
+      sprintf(name, "injection");
+    } else if(tid >= OUT_TID) {
+      sprintf(name, "out %d", tid - OUT_TID);
+    } else {
+      sprintf(name, "in %d", tid);
+    }
+    _Begin(out);
+    fprintf(out, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,"
+	    "\"tid\":%d,\"args\":{\"name\":\"%s\"}}", pid, tid, name);
+  }
+}
+
+int main( int argc, char **argv )
+{
+  if((argc < 2) || (argc > 3)) {
+    fprintf(stderr, "Usage: %s trace.bin [out.json]\n", argv[0]);
+    return 1;
+  }
+
+  FILE * in = fopen(argv[1], "rb");
+  if(!in) {
+    fprintf(stderr, "Error: Unable to open event trace file: %s\n", argv[1]);
+    return 1;
+  }
+  FILE * out = (argc > 2) ? fopen(argv[2], "w") : stdout;
+  if(!out) {
+    fprintf(stderr, "Error: Unable to open output file: %s\n", argv[2]);
+    return 1;
+  }
+
+  char header[EventTrace::HEADER_SIZE];
+  uint32_t version, size;
+  if((fread(header, 1, sizeof(header), in) != sizeof(header)) ||
+     memcmp(header, "BSEVENT", 8)) {
+    fprintf(stderr, "Error: Not an event trace file: %s\n", argv[1]);
+    return 1;
+  }
+  memcpy(&version, header + 8, sizeof(version));
+  memcpy(&size, header + 12, sizeof(size));
+  if((version != EventTrace::VERSION) || (size != sizeof(EventRecord))) {
+    fprintf(stderr, "Error: Unsupported event trace version %u "
+	    "(record size %u)\n", version, size);
+    return 1;
+  }
+
+  fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", out);
+
+  EventRecord r;
+  long long records = 0;
+  while(fread(&r, sizeof(r), 1, in) == 1) {
+    ++records;
+    if(r.type >= EventTrace::NUM_EVENT_TYPES) {
+      fprintf(stderr, "Error: Invalid event type %d in record %lld\n", 
+	      r.type, records);
+      return 1;
+    }
+    char const * const name = event_names[r.type];
+    int pid, tid;
+    switch(r.type) {
+    case EventTrace::INJECT:
+    case EventTrace::EJECT:
+      pid = NODE_PID + r.module;
+      _Track(out, pid, 0);
+      _Begin(out);
+      // flits are injected and ejected at different nodes, so the slice 
+      // id has to be global rather than scoped to a process
+      fprintf(out, "{\"ph\":\"%s\",\"cat\":\"flit\",\"name\":\"flit\","
+	      "\"id2\":{\"global\":%d},\"pid\":%d,\"tid\":0,\"ts\":%lld,"
+	      "\"args\":{\"packet\":%d,\"class\":%d,\"vc\":%d",
+	      (r.type == EventTrace::INJECT) ? "b" : "e", r.flit, pid, 
+	      (long long)r.time, r.packet, r.cl, r.vc);
+      if((r.type == EventTrace::INJECT) && (r.arg >= 0)) {
+	fprintf(out, ",\"dest\":%d", r.arg);
+      }
+      fputs("}}", out);
+      break;
+    case EventTrace::LINK:
+      if(r.module >= 0) {
+	pid = r.module;
+	tid = OUT_TID + r.port;
+      } else {
+	// injection channel; show it on the receiving router
+	pid = r.arg;
+	tid = INJECT_TID;
+      }
+      if(pid < 0) {
+	// channel between two terminals (no routers); nothing to attach to
+	break;
+      }
+      _Track(out, pid, tid);
+      _Begin(out);
+      fprintf(out, "{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,"
+	      "\"ts\":%lld,\"dur\":%d,\"args\":{\"flit\":%d,\"packet\":%d,"
+	      "\"class\":%d,\"vc\":%d,\"sink\":%d}}", 
+	      name, pid, tid, (long long)r.time, r.aux, r.flit, r.packet, 
+	      r.cl, r.vc, r.arg);
+      break;
+    default:
+      pid = r.module;
+      tid = r.port;
+      _Track(out, pid, tid);
+      _Begin(out);
+      fprintf(out, "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":%d,"
+	      "\"tid\":%d,\"ts\":%lld,\"args\":{\"flit\":%d,\"packet\":%d,"
+	      "\"class\":%d,\"vc\":%d", 
+	      name, pid, tid, (long long)r.time, r.flit, r.packet, r.cl, r.vc);
+      if(r.type != EventTrace::ROUTE) {
+	fprintf(out, ",\"output\":%d,\"out_vc\":%d", r.arg, r.aux);
+      }
+      fputs("}}", out);
+      break;
+    }
+  }
+
+  fputs("\n]}\n", out);
+
+  fclose(in);
+  if(out != stdout) {
+    fclose(out);
+  }
+  fprintf(stderr, "Converted %lld events.\n", records);
+  return 0;
+}